@@ -0,0 +1,1129 @@
+#include <JuceHeader.h>
+#include "../../Source/ChainSmoother.h"
+#include "../../Source/ChannelWorkers.h"
+#include "../../Source/CoefficientCache.h"
+#include "../../Source/CoefficientTable.h"
+#include "../../Source/DynamicPeak.h"
+#include "../../Source/FilterChain.h"
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/RealtimeSafety.h"
+#include "../../Source/SIMDChain.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+//Micro-benchmarks for the DSP chain and the coefficient designers.
+//Every result is printed as one JSON object per line so runs can be diffed between versions.
+//
+//  FilterBenchmarks [--filter=<benchmark>] [--repeats=<n>]
+//
+//benchmarks: chain, smoothed, design, design_accuracy, coefficient_table, coefficient_cache, simd_vs_scalar, parallel, precision, bands,
+//            process_block, dynamic_peak, update_filters
+//checks: realtime, which fails the run (exit code 1) if it finds a violation
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const Slope slopes[] = { Slope_12, Slope_24, Slope_36, Slope_48 };
+    const int channelCounts[] = { 1, 2, 8 };
+    const int blockSizes[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    const double sampleRates[] = { 44100.0, 48000.0, 96000.0, 192000.0 };
+
+    constexpr int samplesPerRun = 1 << 17;
+    int numRepeats = 3;
+    //set by a check that failed
+    bool failed = false;
+
+    //one JSON object per line, fields in insertion order
+    class Record
+    {
+    public:
+        explicit Record(const char* benchmark) : text("{\"benchmark\":\"" + std::string(benchmark) + "\"") { }
+
+        Record& add(const char* key, double value)
+        {
+            char number[64];
+            std::snprintf(number, sizeof(number), "%.6g", value);
+            text += ",\"" + std::string(key) + "\":" + number;
+            return *this;
+        }
+
+        Record& add(const char* key, const char* value)
+        {
+            text += ",\"" + std::string(key) + "\":\"" + value + "\"";
+            return *this;
+        }
+
+        void print() const { std::cout << text << "}" << std::endl; }
+
+    private:
+        std::string text;
+    };
+
+    ChainSettings makeSettings(Slope slope)
+    {
+        ChainSettings settings;
+        settings.lowCutFreq = 80.0f;
+        settings.highCutFreq = 12000.0f;
+        settings.peakFreq = 1000.0f;
+        settings.peakGainInDecibels = 6.0f;
+        settings.peakQuality = 1.0f;
+        settings.lowCutSlope = slope;
+        settings.highCutSlope = slope;
+        return settings;
+    }
+
+    std::vector<std::vector<float>> makeNoise(int numChannels, int numSamples)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+        std::vector<std::vector<float>> channels((size_t) numChannels, std::vector<float>((size_t) numSamples));
+
+        for(auto& channel : channels)
+            for(auto& sample : channel)
+                sample = distribution(generator);
+
+        return channels;
+    }
+
+    template<typename SampleType>
+    std::vector<SampleType*> getPointers(std::vector<std::vector<SampleType>>& channels)
+    {
+        std::vector<SampleType*> pointers;
+
+        for(auto& channel : channels)
+            pointers.push_back(channel.data());
+
+        return pointers;
+    }
+
+    //copies the input back over a buffer a run has filtered in place; the channels stay where they are
+    template<typename SampleType>
+    void refill(std::vector<std::vector<SampleType>>& buffer, const std::vector<std::vector<float>>& input)
+    {
+        for(size_t ch = 0; ch < buffer.size(); ch++)
+            std::copy(input[ch].begin(), input[ch].end(), buffer[ch].begin());
+    }
+
+    using ParameterSetter = std::function<void(FilterPluginAudioProcessor&)>;
+
+    //a processor hosted the way the plugin wrappers host it: stereo in and out, the sidechain off.
+    //setParameters runs before prepareToPlay, which designs its settings, so nothing ramps from the first block
+    std::unique_ptr<FilterPluginAudioProcessor> makeProcessor(double sampleRate, int blockSize, bool doublePrecision,
+                                                              const ParameterSetter& setParameters = {})
+    {
+        auto processor = std::make_unique<FilterPluginAudioProcessor>();
+        processor->setProcessingPrecision(doublePrecision ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+        processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+
+        if(setParameters)
+            setParameters(*processor);
+
+        processor->prepareToPlay(sampleRate, blockSize);
+        return processor;
+    }
+
+    //off the audio thread, as a host's automation or the editor changes it; value in the parameter's own range
+    void setParameter(FilterPluginAudioProcessor& processor, const juce::String& id, float value)
+    {
+        auto* parameter = processor.apvts.getParameter(id);
+        jassert(parameter != nullptr);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    //the cuts and peak of makeSettings on the processor's parameters
+    void setChainParameters(FilterPluginAudioProcessor& processor, Slope slope)
+    {
+        const auto settings = makeSettings(slope);
+        setParameter(processor, "LowCut Freq", settings.lowCutFreq);
+        setParameter(processor, "HighCut Freq", settings.highCutFreq);
+        setParameter(processor, "Peak Freq", settings.peakFreq);
+        setParameter(processor, "Peak Gain", settings.peakGainInDecibels);
+        setParameter(processor, "Peak Quality", settings.peakQuality);
+        setParameter(processor, "LowCut Slope", (float) settings.lowCutSlope);
+        setParameter(processor, "HighCut Slope", (float) settings.highCutSlope);
+    }
+
+    template<typename SampleType>
+    void fillNoise(juce::AudioBuffer<SampleType>& buffer, juce::Random& random)
+    {
+        for(int ch = 0; ch < buffer.getNumChannels(); ch++)
+            for(int i = 0; i < buffer.getNumSamples(); i++)
+                buffer.setSample(ch, i, (SampleType) (random.nextFloat() * 2.0f - 1.0f));
+    }
+
+    //best of numRepeats runs of `function`, in ns; `setUp` runs untimed before each
+    template<typename Function, typename SetUp>
+    double timeBest(Function&& function, SetUp&& setUp)
+    {
+        auto best = std::numeric_limits<double>::max();
+
+        for(int repeat = 0; repeat < numRepeats; repeat++) {
+            setUp();
+            const auto begin = Clock::now();
+            function();
+            const std::chrono::duration<double, std::nano> elapsed = Clock::now() - begin;
+            best = juce::jmin(best, elapsed.count());
+        }
+
+        return best;
+    }
+
+    template<typename Function>
+    double timeBest(Function&& function)
+    {
+        return timeBest(function, [] { });
+    }
+
+    //runs `processBlock(start, length)` over samplesPerRun samples in blocks, in ns. Blocks filter
+    //in place, so `setUp` restores the input before each run: otherwise every repeat would filter
+    //the previous one's output and the gain compound
+    template<typename ProcessBlock, typename SetUp>
+    double timeBlocks(int blockSize, ProcessBlock&& processBlock, SetUp&& setUp)
+    {
+        return timeBest([&] {
+            for(int start = 0; start < samplesPerRun; start += blockSize)
+                processBlock(start, juce::jmin(blockSize, samplesPerRun - start));
+        }, setUp);
+    }
+
+    //steady-state cost of the processBlock path: parameters static, one SIMDChain for all channels
+    void benchmarkChain()
+    {
+        for(auto sampleRate : sampleRates)
+            for(auto slope : slopes)
+                for(auto numChannels : channelCounts) {
+                    ChainCoefficients coefficients;
+                    makeChainCoefficients(coefficients, makeSettings(slope), sampleRate);
+
+                    const auto input = makeNoise(numChannels, samplesPerRun);
+                    auto buffer = input;
+                    auto pointers = getPointers(buffer);
+
+                    auto chain = std::make_unique<SIMDChain>();
+                    chain->prepare(numChannels);
+                    chain->setCoefficients(coefficients);
+
+                    for(auto blockSize : blockSizes) {
+                        const auto ns = timeBlocks(blockSize, [&](int start, int length) {
+                            chain->process(pointers.data(), numChannels, start, length);
+                        }, [&] { refill(buffer, input); });
+
+                        Record("chain")
+                            .add("sample_rate", sampleRate)
+                            .add("slope_db_oct", 12 * (slope + 1))
+                            .add("channels", numChannels)
+                            .add("block", blockSize)
+                            .add("ns_per_sample", ns / ((double) samplesPerRun * numChannels))
+                            .print();
+                    }
+                }
+    }
+
+    //processBlock while automation is moving: ChainSmoother ramps and the chain is redesigned every 32 samples
+    void benchmarkSmoothed()
+    {
+        constexpr int updateInterval = 32;
+        constexpr int numChannels = 2;
+
+        for(auto sampleRate : sampleRates)
+            for(auto blockSize : blockSizes) {
+                const auto input = makeNoise(numChannels, samplesPerRun);
+                auto buffer = input;
+                auto pointers = getPointers(buffer);
+
+                const auto settings = makeSettings(Slope_48);
+                auto otherSettings = settings;
+                otherSettings.lowCutFreq = 400.0f;
+                otherSettings.peakGainInDecibels = -6.0f;
+
+                ChainSmoother smoother;
+                smoother.prepare(sampleRate, 1.0, settings);
+
+                ChainCoefficients coefficients;
+                auto chain = std::make_unique<SIMDChain>();
+                chain->prepare(numChannels);
+
+                bool flip = false;
+
+                const auto ns = timeBlocks(blockSize, [&](int start, int length) {
+                    //a new target every block keeps the ramps running the whole time
+                    flip = !flip;
+                    smoother.setTarget(flip ? otherSettings : settings);
+
+                    for(int offset = 0; offset < length; offset += updateInterval) {
+                        const auto subLength = juce::jmin(updateInterval, length - offset);
+                        makeChainCoefficients(coefficients, smoother.advance(subLength), sampleRate);
+                        chain->setCoefficients(coefficients);
+                        chain->process(pointers.data(), numChannels, start + offset, subLength);
+                    }
+                }, [&] { refill(buffer, input); });
+
+                Record("smoothed")
+                    .add("sample_rate", sampleRate)
+                    .add("slope_db_oct", 48)
+                    .add("channels", numChannels)
+                    .add("block", blockSize)
+                    .add("update_interval", updateInterval)
+                    .add("ns_per_sample", ns / ((double) samplesPerRun * numChannels))
+                    .print();
+            }
+    }
+
+    //cost of one coefficient redesign, per designer, over randomised settings
+    void benchmarkDesign()
+    {
+        constexpr int numUpdates = 1 << 18;
+
+        std::vector<ChainSettings> settings(256);
+        std::mt19937 generator(99);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        for(auto& s : settings) {
+            s = makeSettings(slopes[generator() % 4]);
+            s.lowCutFreq = 20.0f * std::pow(1000.0f, unit(generator));
+            s.highCutFreq = 20.0f * std::pow(1000.0f, unit(generator));
+            s.peakFreq = 20.0f * std::pow(1000.0f, unit(generator));
+            s.peakGainInDecibels = -24.0f + 48.0f * unit(generator);
+        }
+
+        auto matchedSettings = settings;
+
+        for(auto& s : matchedSettings)
+            s.designMode = DesignMode_Matched;
+
+        ChainCoefficients sink;
+        CoefficientTable table;
+        table.prepare(CoefficientTable::defaultSegmentsPerOctave);
+
+        auto run = [&](const char* designer, double sampleRate, auto&& design, const std::vector<ChainSettings>& designSettings) {
+            const auto ns = timeBest([&] {
+                for(int i = 0; i < numUpdates; i++)
+                    design(designSettings[(size_t) (i & 255)], sampleRate);
+            });
+
+            Record("design")
+                .add("designer", designer)
+                .add("sample_rate", sampleRate)
+                .add("ns_per_update", ns / numUpdates)
+                .print();
+        };
+
+        for(auto sampleRate : sampleRates) {
+            auto peak = [&](const ChainSettings& s, double sr) { makePeakFilter(sink.peak, s, sr); };
+            auto lowCut = [&](const ChainSettings& s, double sr) { makeLowCutFilter(sink.lowCut, s, sr); };
+            auto highCut = [&](const ChainSettings& s, double sr) { makeHighCutFilter(sink.highCut, s, sr); };
+            auto chain = [&](const ChainSettings& s, double sr) { makeChainCoefficients(sink, s, sr); };
+
+            run("peak", sampleRate, peak, settings);
+            run("low_cut", sampleRate, lowCut, settings);
+            run("high_cut", sampleRate, highCut, settings);
+            run("chain", sampleRate, chain, settings);
+            run("peak_table", sampleRate, [&](const ChainSettings& s, double sr) { makePeakFilter(sink.peak, s, sr, &table); }, settings);
+            run("low_cut_table", sampleRate, [&](const ChainSettings& s, double sr) { makeLowCutFilter(sink.lowCut, s, sr, &table); }, settings);
+            run("high_cut_table", sampleRate, [&](const ChainSettings& s, double sr) { makeHighCutFilter(sink.highCut, s, sr, &table); }, settings);
+            run("chain_table", sampleRate, [&](const ChainSettings& s, double sr) { makeChainCoefficients(sink, s, sr, &table); }, settings);
+            run("peak_matched", sampleRate, peak, matchedSettings);
+            run("low_cut_matched", sampleRate, lowCut, matchedSettings);
+            run("high_cut_matched", sampleRate, highCut, matchedSettings);
+            run("chain_matched", sampleRate, chain, matchedSettings);
+        }
+
+        //keeps the designs from being optimised away
+        volatile double keep = sink.peak.b0 + sink.lowCut.stages[0].b0 + sink.highCut.stages[0].b0;
+        juce::ignoreUnused(keep);
+    }
+
+    //magnitude error of the bilinear and matched designs against the analog prototypes, in dB,
+    //on a log-frequency grid from 20 Hz up to 20 kHz or Nyquist; the peak's worst case over gain and Q.
+    //Points where the prototype is below -40 dB are deep in a cut's stop band and left out.
+    void benchmarkDesignAccuracy()
+    {
+        constexpr int numPoints = 512;
+        constexpr double minMagnitude = 0.01;
+
+        auto measure = [](const ChainSettings& settings, double sampleRate, double& maxError, double& sumSquares, int& count) {
+            ChainCoefficients coefficients;
+            makeChainCoefficients(coefficients, settings, sampleRate);
+
+            for(int i = 0; i < numPoints; i++) {
+                const auto frequency = 20.0 * std::pow(1000.0, i / (numPoints - 1.0));
+
+                if(frequency >= sampleRate * 0.5)
+                    break;
+
+                const auto prototype = getPrototypeMagnitude(settings, frequency);
+
+                if(prototype < minMagnitude)
+                    continue;
+
+                const auto error = std::abs(juce::Decibels::gainToDecibels(coefficients.getMagnitudeForFrequency(frequency, sampleRate) / prototype, -200.0));
+                maxError = juce::jmax(maxError, error);
+                sumSquares += error * error;
+                count++;
+            }
+        };
+
+        const char* modeNames[] = { "bilinear", "matched" };
+
+        for(auto sampleRate : sampleRates)
+            for(auto frequency : { 1000.0f, 8000.0f, 16000.0f })
+                for(const auto* designer : { "peak", "low_cut", "high_cut" })
+                    for(int mode = 0; mode < numDesignModes; mode++) {
+                        double maxError = 0.0, sumSquares = 0.0;
+                        int count = 0;
+
+                        auto settings = makeSettings(Slope_24);
+                        settings.lowCutFreq = minCutFrequency;
+                        settings.highCutFreq = maxCutFrequency;
+                        settings.peakGainInDecibels = 0.0f;
+                        settings.designMode = static_cast<DesignMode>(mode);
+
+                        if(std::strcmp(designer, "peak") == 0) {
+                            settings.peakFreq = frequency;
+
+                            for(auto gain : { -12.0f, 12.0f })
+                                for(auto quality : { 0.7f, 3.0f }) {
+                                    settings.peakGainInDecibels = gain;
+                                    settings.peakQuality = quality;
+                                    measure(settings, sampleRate, maxError, sumSquares, count);
+                                }
+                        }
+                        else {
+                            for(auto slope : { Slope_12, Slope_48 }) {
+                                if(std::strcmp(designer, "low_cut") == 0) {
+                                    settings.lowCutFreq = frequency;
+                                    settings.lowCutSlope = slope;
+                                }
+                                else {
+                                    settings.highCutFreq = frequency;
+                                    settings.highCutSlope = slope;
+                                }
+
+                                measure(settings, sampleRate, maxError, sumSquares, count);
+                            }
+                        }
+
+                        Record("design_accuracy")
+                            .add("designer", designer)
+                            .add("mode", modeNames[mode])
+                            .add("sample_rate", sampleRate)
+                            .add("frequency", frequency)
+                            .add("max_error_db", maxError)
+                            .add("rms_error_db", count > 0 ? std::sqrt(sumSquares / count) : 0.0)
+                            .print();
+                    }
+    }
+
+    //memory and accuracy of the coefficient lookup table against the direct designs, per resolution
+    void benchmarkCoefficientTable()
+    {
+        for(auto segmentsPerOctave : { 8, 16, 32, 64, 128 }) {
+            CoefficientTable table;
+            table.prepare(segmentsPerOctave);
+
+            for(auto sampleRate : sampleRates) {
+                const auto report = table.measureAccuracy(sampleRate, 1000);
+
+                Record("coefficient_table")
+                    .add("segments_per_octave", segmentsPerOctave)
+                    .add("bytes", (double) table.getMemoryUsage())
+                    .add("sample_rate", sampleRate)
+                    .add("max_tan_error", report.maxTanError)
+                    .add("max_gain_error", report.maxGainError)
+                    .add("max_coefficient_error", report.maxCoefficientError)
+                    .add("max_magnitude_error_db", report.maxMagnitudeErrorInDecibels)
+                    .print();
+            }
+        }
+    }
+
+    //instances designing their chains through the shared cache against designing them directly:
+    //every instance at its own settings (all misses once the cache is full) or all at the same ones
+    void benchmarkCoefficientCache()
+    {
+        constexpr int numUpdates = 1 << 16;
+        constexpr double sampleRate = 48000.0;
+
+        std::mt19937 generator(7);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        for(int numBands : { 0, 4 }) {
+            for(int numDistinct : { 1, 16, 256, 4096 }) {
+                std::vector<ChainSettings> settings((size_t) numDistinct);
+
+                for(auto& s : settings) {
+                    s = makeSettings(slopes[generator() % 4]);
+                    s.lowCutFreq = 20.0f * std::pow(1000.0f, unit(generator));
+                    s.peakFreq = 20.0f * std::pow(1000.0f, unit(generator));
+
+                    for(int k = 0; k < numBands; k++) {
+                        s.bands[(size_t) k].type = BandType_Peak;
+                        s.bands[(size_t) k].freq = 20.0f * std::pow(1000.0f, unit(generator));
+                        s.bands[(size_t) k].gainInDecibels = -6.0f;
+                    }
+                }
+
+                ChainCoefficients sink;
+                CoefficientCache cache;
+
+                const auto direct = timeBest([&] {
+                    for(int i = 0; i < numUpdates; i++)
+                        makeChainCoefficients(sink, settings[(size_t) (i % numDistinct)], sampleRate);
+                });
+
+                const auto cached = timeBest([&] {
+                    for(int i = 0; i < numUpdates; i++)
+                        cache.makeChainCoefficients(sink, settings[(size_t) (i % numDistinct)], sampleRate);
+                });
+
+                const auto statistics = cache.getStatistics();
+                const auto lookups = (double) (statistics.hits + statistics.misses);
+
+                Record("coefficient_cache")
+                    .add("bands", numBands)
+                    .add("distinct_settings", numDistinct)
+                    .add("ns_per_update_direct", direct / numUpdates)
+                    .add("ns_per_update_cached", cached / numUpdates)
+                    .add("hit_rate", lookups > 0 ? (double) statistics.hits / lookups : 0.0)
+                    .add("evictions", (double) statistics.evictions)
+                    .add("entries", statistics.numEntries)
+                    .print();
+
+                volatile double keep = sink.peak.b0;
+                juce::ignoreUnused(keep);
+            }
+        }
+    }
+
+    //scalar MonoChain per channel against SIMDChain lanes, same coefficients and input
+    void benchmarkSIMDChain()
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+
+        ChainCoefficients coefficients;
+        makeChainCoefficients(coefficients, makeSettings(Slope_48), sampleRate);
+
+        for(int numChannels : { 1, 2, 4, 8, 16 }) {
+            const auto input = makeNoise(numChannels, samplesPerRun);
+            auto scalarBuffer = input;
+            auto simdBuffer = input;
+            auto scalarPointers = getPointers(scalarBuffer);
+            auto simdPointers = getPointers(simdBuffer);
+
+            std::vector<MonoChain<float>> monoChains((size_t) numChannels);
+            for(auto& chain : monoChains)
+                chain.setCoefficients(coefficients);
+
+            auto simdChain = std::make_unique<SIMDChain>();
+            simdChain->prepare(numChannels);
+            simdChain->setCoefficients(coefficients);
+
+            const auto scalarNs = timeBlocks(blockSize, [&](int start, int length) {
+                for(int ch = 0; ch < numChannels; ch++)
+                    monoChains[(size_t) ch].process(scalarPointers[(size_t) ch] + start, length);
+            }, [&] { refill(scalarBuffer, input); });
+
+            const auto simdNs = timeBlocks(blockSize, [&](int start, int length) {
+                simdChain->process(simdPointers.data(), numChannels, start, length);
+            }, [&] { refill(simdBuffer, input); });
+
+            //both sides filtered the same input, from the same state, in the last run
+            float maxError = 0.0f;
+            for(size_t ch = 0; ch < (size_t) numChannels; ch++)
+                for(size_t i = 0; i < (size_t) samplesPerRun; i++)
+                    maxError = juce::jmax(maxError, std::abs(scalarBuffer[ch][i] - simdBuffer[ch][i]));
+
+            const auto numSamples = (double) samplesPerRun * numChannels;
+
+            Record("simd_vs_scalar")
+                .add("lanes", SIMDChain::numLanes)
+                .add("channels", numChannels)
+                .add("block", blockSize)
+                .add("scalar_ns_per_sample", scalarNs / numSamples)
+                .add("simd_ns_per_sample", simdNs / numSamples)
+                .add("speedup", scalarNs / simdNs)
+                .add("max_abs_error", maxError)
+                .print();
+        }
+    }
+
+    //one chain variant of benchmarkPrecision: cost per sample, and error against the long double reference
+    template<typename Chain>
+    void measurePrecision(const char* variant, double sampleRate, float lowCutFreq, const ChainCoefficients& coefficients,
+                          const std::vector<std::vector<float>>& input, const std::vector<std::vector<long double>>& reference)
+    {
+        using SampleType = typename Chain::SampleType;
+        constexpr int blockSize = 512;
+        const auto numChannels = (int) input.size();
+
+        std::vector<std::vector<SampleType>> buffer;
+        for(auto& channel : input)
+            buffer.emplace_back(channel.begin(), channel.end());
+
+        auto pointers = getPointers(buffer);
+
+        auto chain = std::make_unique<Chain>();
+        chain->prepare(numChannels);
+        chain->setCoefficients(coefficients);
+        chain->process(pointers.data(), numChannels, 0, samplesPerRun);
+
+        //second half only, the cuts need a while to settle
+        long double errorPower = 0, signalPower = 0, errorSum = 0;
+        const auto first = samplesPerRun / 2;
+
+        for(size_t ch = 0; ch < buffer.size(); ch++)
+            for(size_t i = (size_t) first; i < (size_t) samplesPerRun; i++) {
+                const auto error = (long double) buffer[ch][i] - reference[ch][i];
+                errorPower += error * error;
+                signalPower += reference[ch][i] * reference[ch][i];
+                errorSum += error;
+            }
+
+        const auto numMeasured = (long double) (samplesPerRun - first) * numChannels;
+
+        const auto ns = timeBlocks(blockSize, [&](int start, int length) {
+            chain->process(pointers.data(), numChannels, start, length);
+        }, [&] {
+            refill(buffer, input);
+            //reset switches the stages off until the next setCoefficients
+            chain->reset();
+            chain->setCoefficients(coefficients);
+        });
+
+        Record("precision")
+            .add("variant", variant)
+            .add("sample_rate", sampleRate)
+            .add("low_cut_hz", lowCutFreq)
+            .add("slope_db_oct", 48)
+            .add("ns_per_sample", ns / ((double) samplesPerRun * numChannels))
+            .add("error_db", (double) (10.0L * std::log10(std::max(errorPower / signalPower, 1.0e-40L))))
+            .add("dc_error", (double) (errorSum / numMeasured))
+            .print();
+    }
+
+    //one SIMDChain run serially against its channel groups spread over ChannelWorkers, per channel
+    //count and block size; threshold_block is the smallest block from which the workers stay ahead
+    //(-1: never), the value to give setParallelThreshold on this machine instead of the untuned default
+    void benchmarkParallel()
+    {
+        constexpr double sampleRate = 48000.0;
+
+        ChainCoefficients coefficients;
+        makeChainCoefficients(coefficients, makeSettings(Slope_48), sampleRate);
+
+        for(auto numChannels : { 8, 16, 32 }) {
+            const auto numGroups = SIMDChain::getNumGroups(numChannels);
+            const auto numWorkers = juce::jmax(0, juce::jmin(numGroups - 1, juce::SystemStats::getNumCpus() - 1));
+
+            ChannelWorkers workers;
+            workers.prepare(&workers, numWorkers);
+
+            const auto input = makeNoise(numChannels, samplesPerRun);
+            auto buffer = input;
+            auto pointers = getPointers(buffer);
+
+            auto serial = std::make_unique<SIMDChain>();
+            auto parallel = std::make_unique<SIMDChain>();
+
+            for(auto* chain : { serial.get(), parallel.get() }) {
+                chain->prepare(numChannels);
+                chain->setCoefficients(coefficients);
+            }
+
+            int threshold = -1;
+
+            for(auto blockSize : blockSizes) {
+                const auto serialNs = timeBlocks(blockSize, [&](int start, int length) {
+                    serial->process(pointers.data(), numChannels, start, length);
+                }, [&] { refill(buffer, input); });
+
+                const auto parallelNs = timeBlocks(blockSize, [&](int start, int length) {
+                    auto task = [&](int group) { parallel->processChannelGroup(group, pointers.data(), numChannels, start, length); };
+                    workers.run(numGroups, task);
+                    parallel->finishBlock(length);
+                }, [&] { refill(buffer, input); });
+
+                if(serialNs <= parallelNs)
+                    threshold = -1;
+                else if(threshold < 0)
+                    threshold = blockSize;
+
+                Record("parallel")
+                    .add("channels", numChannels)
+                    .add("workers", numWorkers)
+                    .add("block", blockSize)
+                    .add("ns_per_sample_serial", serialNs / ((double) samplesPerRun * numChannels))
+                    .add("ns_per_sample_parallel", parallelNs / ((double) samplesPerRun * numChannels))
+                    .add("speedup", serialNs / parallelNs)
+                    .print();
+            }
+
+            Record("parallel_threshold")
+                .add("channels", numChannels)
+                .add("workers", numWorkers)
+                .add("threshold_block", threshold)
+                .print();
+        }
+    }
+
+    //float direct form against float state variable and double direct form, for low cuts near DC
+    void benchmarkPrecision()
+    {
+        constexpr int numChannels = 2;
+
+        for(auto sampleRate : { 48000.0, 192000.0 })
+            //20 Hz is the neutral end of the range, where the low cut is switched off
+            for(auto lowCutFreq : { 21.0f, 40.0f, 200.0f }) {
+                auto settings = makeSettings(Slope_48);
+                settings.lowCutFreq = lowCutFreq;
+
+                ChainCoefficients coefficients;
+                makeChainCoefficients(coefficients, settings, sampleRate);
+
+                const auto input = makeNoise(numChannels, samplesPerRun);
+                std::vector<std::vector<long double>> reference;
+
+                for(auto& channel : input) {
+                    reference.emplace_back(channel.begin(), channel.end());
+
+                    MonoChain<long double> referenceChain;
+                    referenceChain.setCoefficients(coefficients);
+                    referenceChain.process(reference.back().data(), samplesPerRun);
+                }
+
+                measurePrecision<SIMDChain>("direct_form_float", sampleRate, lowCutFreq, coefficients, input, reference);
+                measurePrecision<SIMDStateVariableChain>("state_variable_float", sampleRate, lowCutFreq, coefficients, input, reference);
+                measurePrecision<SIMDChainDouble>("direct_form_double", sampleRate, lowCutFreq, coefficients, input, reference);
+            }
+    }
+
+    //cost of the parametric bands against the number switched on, the rest of the chain as in benchmarkChain
+    void benchmarkBands()
+    {
+        constexpr int numChannels = 2;
+        constexpr int blockSize = 512;
+        constexpr double sampleRate = 48000.0;
+
+        for(auto numActive : { 0, 4, 8, maxBands }) {
+            auto settings = makeSettings(Slope_24);
+
+            //every other band (then the rest) so the active ones are not simply the first few
+            for(int i = 0; i < numActive; i++) {
+                const auto band = (i * 2) % maxBands + (i * 2) / maxBands;
+                settings.bands[band].type = static_cast<BandType>(BandType_Peak + i % 5);
+                settings.bands[band].freq = getDefaultBandFrequency(band);
+                settings.bands[band].gainInDecibels = 3.0f;
+            }
+
+            ChainCoefficients coefficients;
+            makeChainCoefficients(coefficients, settings, sampleRate);
+
+            const auto input = makeNoise(numChannels, samplesPerRun);
+            auto buffer = input;
+            auto pointers = getPointers(buffer);
+
+            auto chain = std::make_unique<SIMDChain>();
+            chain->prepare(numChannels);
+            chain->setCoefficients(coefficients);
+
+            const auto ns = timeBlocks(blockSize, [&](int start, int length) {
+                chain->process(pointers.data(), numChannels, start, length);
+            }, [&] { refill(buffer, input); });
+
+            Record("bands")
+                .add("active_bands", coefficients.bands.numBands)
+                .add("channels", numChannels)
+                .add("block", blockSize)
+                .add("ns_per_sample", ns / ((double) samplesPerRun * numChannels))
+                .print();
+        }
+    }
+
+    //one variant of benchmarkProcessBlock: the processor's processBlock over the noise in blocks, in ns
+    template<typename SampleType>
+    double timeProcessBlock(FilterPluginAudioProcessor& processor, int blockSize, const std::vector<std::vector<float>>& input)
+    {
+        std::vector<std::vector<SampleType>> buffer;
+        for(auto& channel : input)
+            buffer.emplace_back(channel.begin(), channel.end());
+
+        auto pointers = getPointers(buffer);
+        juce::MidiBuffer midi;
+
+        return timeBlocks(blockSize, [&](int start, int length) {
+            juce::AudioBuffer<SampleType> block(pointers.data(), (int) pointers.size(), start, length);
+            processor.processBlock(block, midi);
+        }, [&] { refill(buffer, input); });
+    }
+
+    //the whole processBlock path with the parameters static, per processing variant and block size:
+    //stereo at 48 kHz, the chain of benchmarkChain at 48 dB/oct. load is the share of real time used
+    void benchmarkProcessBlock()
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numChannels = 2;
+
+        struct Variant {
+            const char* name;
+            bool doublePrecision;
+            ParameterSetter setParameters;
+        };
+
+        const Variant variants[] = {
+            { "direct_form", false, [](FilterPluginAudioProcessor&) { } },
+            { "state_variable", false, [](FilterPluginAudioProcessor& p) { setParameter(p, "Filter Structure", 1.0f); } },
+            { "double", true, [](FilterPluginAudioProcessor&) { } },
+            { "bands_8", false, [](FilterPluginAudioProcessor& p) {
+                for(int k = 0; k < 8; k++) {
+                    setParameter(p, getBandParameterID(k, "Type"), (float) BandType_Peak);
+                    setParameter(p, getBandParameterID(k, "Gain"), 3.0f);
+                }
+            } },
+            { "dynamic_peak", false, [](FilterPluginAudioProcessor& p) {
+                setParameter(p, "Peak Threshold", -20.0f);
+                setParameter(p, "Peak Ratio", 4.0f);
+            } },
+            { "mid_side", false, [](FilterPluginAudioProcessor& p) {
+                setParameter(p, "Channel Mode", 2.0f);
+                setParameter(p, getChannelParameterID(1, "Peak Gain"), -6.0f);
+            } },
+            { "oversampling_4x", false, [](FilterPluginAudioProcessor& p) { setParameter(p, "Oversampling", 2.0f); } },
+            { "linear_phase", false, [](FilterPluginAudioProcessor& p) { setParameter(p, "Phase Mode", 1.0f); } },
+        };
+
+        const auto input = makeNoise(numChannels, samplesPerRun);
+
+        for(auto& variant : variants)
+            for(auto blockSize : { 64, 512, 4096 }) {
+                auto processor = makeProcessor(sampleRate, blockSize, variant.doublePrecision, [&](FilterPluginAudioProcessor& p) {
+                    setChainParameters(p, Slope_48);
+                    variant.setParameters(p);
+                });
+
+                const auto ns = variant.doublePrecision ? timeProcessBlock<double>(*processor, blockSize, input)
+                                                        : timeProcessBlock<float>(*processor, blockSize, input);
+
+                processor->releaseResources();
+
+                Record("process_block")
+                    .add("variant", variant.name)
+                    .add("sample_rate", sampleRate)
+                    .add("channels", numChannels)
+                    .add("block", blockSize)
+                    .add("ns_per_sample", ns / ((double) samplesPerRun * numChannels))
+                    .add("load", ns * 1.0e-9 * sampleRate / samplesPerRun)
+                    .print();
+            }
+    }
+
+    //the dynamic peak against the same band held at a static gain, through processBlock: stereo noise
+    //at 48 kHz with the cuts off, the band where its detector runs at 1/8, 1/2 and the full rate.
+    //ratio is dynamic over static; within_target says whether it stays under dynamicPeakTarget
+    void benchmarkDynamicPeak()
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numChannels = 2;
+        constexpr int blockSize = 512;
+        constexpr double dynamicPeakTarget = 2.0;
+
+        const auto input = makeNoise(numChannels, samplesPerRun);
+
+        for(auto peakFreq : { 200.0f, 1000.0f, 5000.0f }) {
+            auto dynamicProcessor = makeProcessor(sampleRate, blockSize, false, [&](FilterPluginAudioProcessor& p) {
+                setParameter(p, "Peak Freq", peakFreq);
+                setParameter(p, "Peak Threshold", -30.0f);
+                setParameter(p, "Peak Ratio", 4.0f);
+            });
+
+            auto staticProcessor = makeProcessor(sampleRate, blockSize, false, [&](FilterPluginAudioProcessor& p) {
+                setParameter(p, "Peak Freq", peakFreq);
+                setParameter(p, "Peak Gain", -6.0f);
+            });
+
+            const auto peakQuality = dynamicProcessor->apvts.getRawParameterValue("Peak Quality")->load();
+            const auto staticNs = timeProcessBlock<float>(*staticProcessor, blockSize, input);
+            const auto dynamicNs = timeProcessBlock<float>(*dynamicProcessor, blockSize, input);
+            const auto ratio = dynamicNs / staticNs;
+
+            staticProcessor->releaseResources();
+            dynamicProcessor->releaseResources();
+
+            Record("dynamic_peak")
+                .add("peak_freq", peakFreq)
+                .add("decimation", DynamicPeak::getDecimation(sampleRate, peakFreq, peakQuality))
+                .add("static_ns_per_sample", staticNs / ((double) samplesPerRun * numChannels))
+                .add("dynamic_ns_per_sample", dynamicNs / ((double) samplesPerRun * numChannels))
+                .add("ratio", ratio)
+                .add("target", dynamicPeakTarget)
+                .add("within_target", ratio < dynamicPeakTarget ? "yes" : "no")
+                .print();
+        }
+    }
+
+    //the block that takes a new design from the coefficient updater (updateFilters runs at its start)
+    //against a steady block before it, per kind of change; stereo, 512 samples at 48 kHz. Each change
+    //is made off the audio thread and the updater given time to publish it before the timed block.
+    //Every update is a separate event rather than a rerun of the same one, so the times are averages
+    void benchmarkUpdateFilters()
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+        const auto numUpdates = 16 * numRepeats;
+        //several times the updater's poll interval
+        constexpr int updaterWaitMilliseconds = 25;
+        //untimed audio after each change (about 0.4 s), so its ramp or fade is over by the next steady block
+        constexpr int settleBlocks = 40;
+
+        struct Change {
+            const char* name;
+            const char* parameterID;
+            float first, second;
+        };
+
+        const Change changes[] = {
+            //the finished design is taken as it is
+            { "slope", "LowCut Slope", 1.0f, 3.0f },
+            //starts a ramp, redesigned every coefficient update interval
+            { "low_cut_freq", "LowCut Freq", 80.0f, 400.0f },
+            //restarts the chain from silence
+            { "channel_mode", "Channel Mode", 0.0f, 2.0f },
+            //fades out of the other float structure
+            { "filter_structure", "Filter Structure", 0.0f, 1.0f },
+            //fades out of the old rate's path
+            { "oversampling", "Oversampling", 0.0f, 1.0f },
+        };
+
+        for(auto& change : changes) {
+            auto processor = makeProcessor(sampleRate, blockSize, false, [&](FilterPluginAudioProcessor& p) {
+                setChainParameters(p, Slope_48);
+                setParameter(p, change.parameterID, change.first);
+            });
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            juce::MidiBuffer midi;
+            juce::Random random(1234);
+
+            auto timeBlock = [&] {
+                fillNoise(buffer, random);
+                const auto begin = Clock::now();
+                processor->processBlock(buffer, midi);
+                const std::chrono::duration<double, std::nano> elapsed = Clock::now() - begin;
+                return elapsed.count();
+            };
+
+            double steadyNs = 0, updateNs = 0;
+
+            for(int update = 0; update < numUpdates; update++) {
+                for(int block = 0; block < settleBlocks; block++) {
+                    fillNoise(buffer, random);
+                    processor->processBlock(buffer, midi);
+                }
+
+                steadyNs += timeBlock();
+
+                setParameter(*processor, change.parameterID, update % 2 == 0 ? change.second : change.first);
+                juce::Thread::sleep(updaterWaitMilliseconds);
+
+                updateNs += timeBlock();
+            }
+
+            processor->releaseResources();
+
+            Record("update_filters")
+                .add("change", change.name)
+                .add("block", blockSize)
+                .add("updates", numUpdates)
+                .add("ns_per_block_steady", steadyNs / numUpdates)
+                .add("ns_per_block_update", updateNs / numUpdates)
+                .add("ns_per_update", (updateNs - steadyNs) / numUpdates)
+                .print();
+        }
+    }
+
+    //processBlock through every kind of change the audio thread handles, in both precisions, with the
+    //real-time checks counting instead of aborting: any allocation or lock inside processBlock fails
+    //the run. Parameters change from this thread between blocks, as a host's automation would from
+    //another one; the timestamped events go in from a checked scope, as from the audio thread.
+    //Only a build with FILTERPLUGIN_RT_CHECKS=1 (the Debug configuration) checks anything
+    void checkRealtime()
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+        //about 0.2 s of audio per step, long enough for ramps and fades to finish
+        constexpr int blocksPerStep = 20;
+
+        struct Step {
+            const char* name;
+            std::function<void(FilterPluginAudioProcessor&)> apply;
+            //automation events at several offsets into every block
+            bool timestamped { false };
+        };
+
+        const Step steps[] = {
+            { "steady", [](FilterPluginAudioProcessor&) { } },
+            { "ramps", [](FilterPluginAudioProcessor& p) {
+                setParameter(p, "LowCut Freq", 200.0f);
+                setParameter(p, "HighCut Freq", 6000.0f);
+                setParameter(p, "Peak Gain", 9.0f);
+            } },
+            { "slopes", [](FilterPluginAudioProcessor& p) {
+                setParameter(p, "LowCut Slope", 3.0f);
+                setParameter(p, "HighCut Slope", 1.0f);
+            } },
+            { "bands_on", [](FilterPluginAudioProcessor& p) {
+                for(int k = 0; k < 8; k++) {
+                    setParameter(p, getBandParameterID(k, "Type"), (float) (BandType_Peak + k % 5));
+                    setParameter(p, getBandParameterID(k, "Gain"), 4.0f);
+                }
+            } },
+            { "band_types", [](FilterPluginAudioProcessor& p) {
+                for(int k = 0; k < 8; k++)
+                    setParameter(p, getBandParameterID(k, "Type"), (float) ((BandType_Peak + k + 1) % (BandType_BandPass + 1)));
+            } },
+            { "timestamped", [](FilterPluginAudioProcessor&) { }, true },
+            { "left_right", [](FilterPluginAudioProcessor& p) {
+                setParameter(p, "Channel Mode", 1.0f);
+                setParameter(p, getChannelParameterID(1, "Peak Gain"), -6.0f);
+            } },
+            { "mid_side", [](FilterPluginAudioProcessor& p) { setParameter(p, "Channel Mode", 2.0f); } },
+            { "linked", [](FilterPluginAudioProcessor& p) { setParameter(p, "Channel Mode", 0.0f); } },
+            { "matched", [](FilterPluginAudioProcessor& p) { setParameter(p, "Filter Design", 1.0f); } },
+            { "state_variable", [](FilterPluginAudioProcessor& p) { setParameter(p, "Filter Structure", 1.0f); } },
+            { "direct_form", [](FilterPluginAudioProcessor& p) { setParameter(p, "Filter Structure", 0.0f); } },
+            { "dynamic_peak", [](FilterPluginAudioProcessor& p) {
+                setParameter(p, "Peak Threshold", -30.0f);
+                setParameter(p, "Peak Ratio", 4.0f);
+            } },
+            { "dynamic_off", [](FilterPluginAudioProcessor& p) { setParameter(p, "Peak Ratio", 1.0f); } },
+            { "oversampling_2x", [](FilterPluginAudioProcessor& p) { setParameter(p, "Oversampling", 1.0f); } },
+            { "oversampling_8x_fir", [](FilterPluginAudioProcessor& p) {
+                setParameter(p, "Oversampling", 3.0f);
+                setParameter(p, "Oversampling Filter", 1.0f);
+            } },
+            { "oversampling_off", [](FilterPluginAudioProcessor& p) {
+                setParameter(p, "Oversampling", 0.0f);
+                setParameter(p, "Oversampling Filter", 0.0f);
+            } },
+            { "linear_phase", [](FilterPluginAudioProcessor& p) { setParameter(p, "Phase Mode", 1.0f); } },
+            { "kernel_length", [](FilterPluginAudioProcessor& p) { setParameter(p, "Linear Phase Length", 3.0f); } },
+            { "minimum_phase", [](FilterPluginAudioProcessor& p) { setParameter(p, "Phase Mode", 0.0f); } },
+            { "program", [](FilterPluginAudioProcessor& p) { p.setCurrentProgram(juce::jmin(1, p.getNumPrograms() - 1)); } },
+        };
+
+        RealtimeSafety::setTrapOnViolation(false);
+
+        for(auto doublePrecision : { false, true }) {
+            auto processor = makeProcessor(sampleRate, blockSize, doublePrecision);
+            const auto eventIndex = processor->apvts.getParameter("Peak Freq")->getParameterIndex();
+
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            juce::AudioBuffer<double> doubleBuffer(2, blockSize);
+            juce::MidiBuffer midi;
+            juce::Random random(1234);
+
+            for(auto& step : steps) {
+                step.apply(*processor);
+                RealtimeSafety::resetViolationCount();
+
+                for(int block = 0; block < blocksPerStep; block++) {
+                    if(step.timestamped) {
+                        RealtimeSafety::ScopedRealtimeCheck realtimeCheck;
+
+                        for(int offset = 0; offset < blockSize; offset += blockSize / 4)
+                            processor->addParameterEvent(eventIndex, random.nextFloat(), offset);
+                    }
+
+                    if(doublePrecision) {
+                        fillNoise(doubleBuffer, random);
+                        processor->processBlock(doubleBuffer, midi);
+                    }
+                    else {
+                        fillNoise(buffer, random);
+                        processor->processBlock(buffer, midi);
+                    }
+
+                    //about a block's length in real time, so the updater's designs land in the middle of a step
+                    juce::Thread::sleep(10);
+                }
+
+                const auto violations = RealtimeSafety::getViolationCount();
+                failed = failed || violations > 0;
+
+                Record("realtime")
+                    .add("checks", FILTERPLUGIN_RT_CHECKS ? "on" : "off")
+                    .add("precision", doublePrecision ? "double" : "float")
+                    .add("step", step.name)
+                    .add("blocks", blocksPerStep)
+                    .add("violations", violations)
+                    .print();
+            }
+
+            processor->releaseResources();
+        }
+
+        RealtimeSafety::setTrapOnViolation(true);
+    }
+
+    struct Benchmark {
+        const char* name;
+        void (*run)();
+    };
+
+    const Benchmark benchmarks[] = {
+        { "chain", benchmarkChain },
+        { "smoothed", benchmarkSmoothed },
+        { "design", benchmarkDesign },
+        { "design_accuracy", benchmarkDesignAccuracy },
+        { "coefficient_table", benchmarkCoefficientTable },
+        { "coefficient_cache", benchmarkCoefficientCache },
+        { "simd_vs_scalar", benchmarkSIMDChain },
+        { "parallel", benchmarkParallel },
+        { "precision", benchmarkPrecision },
+        { "bands", benchmarkBands },
+        { "process_block", benchmarkProcessBlock },
+        { "dynamic_peak", benchmarkDynamicPeak },
+        { "update_filters", benchmarkUpdateFilters },
+        { "realtime", checkRealtime },
+    };
+
+    std::string getOption(int argc, char* argv[], const std::string& name)
+    {
+        const auto prefix = name + "=";
+
+        for(int i = 1; i < argc; i++)
+            if(std::strncmp(argv[i], prefix.c_str(), prefix.size()) == 0)
+                return argv[i] + prefix.size();
+
+        return {};
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    //the processor's parameters and latency notifier start timers, which need a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const auto filter = getOption(argc, argv, "--filter");
+    const auto repeats = getOption(argc, argv, "--repeats");
+
+    if(!repeats.empty())
+        numRepeats = juce::jmax(1, std::atoi(repeats.c_str()));
+
+    for(auto& benchmark : benchmarks)
+        if(filter.empty() || filter == benchmark.name)
+            benchmark.run();
+
+    return failed ? 1 : 0;
+}
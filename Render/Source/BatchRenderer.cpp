@@ -0,0 +1,210 @@
+#include "BatchRenderer.h"
+#include "../../Source/SIMDChain.h"
+
+class BatchRenderer::RenderJob : public juce::ThreadPoolJob
+{
+public:
+    RenderJob(BatchRenderer& o, const juce::File& f, Result& r)
+        : juce::ThreadPoolJob("Render " + f.getFileName()), owner(o), file(f), result(r)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        result = owner.renderFile(file);
+        
+        if(owner.remainingJobs.fetch_sub(1) == 1)
+            owner.jobsFinished.signal();
+        
+        return jobHasFinished;
+    }
+
+private:
+    BatchRenderer& owner;
+    juce::File file;
+    Result& result;
+};
+
+BatchRenderer::BatchRenderer(const Options& o)
+    : options(o), pool(juce::jmax(1, o.numThreads))
+{
+    formatManager.registerBasicFormats();
+}
+
+BatchRenderer::~BatchRenderer()
+{
+    pool.removeAllJobs(true, 10000);
+}
+
+juce::Array<BatchRenderer::Result> BatchRenderer::render(const juce::Array<juce::File>& inputs)
+{
+    juce::Array<Result> results;
+    results.resize(inputs.size());
+    
+    //inputs of the same name from different directories would all write one file, and an output
+    //must not replace an input another job is still reading: the first input to claim a name wins
+    juce::Array<juce::File> claimedOutputs;
+    juce::Array<int> toRender;
+    
+    for(int i = 0; i < inputs.size(); i++) {
+        auto& result = results.getReference(i);
+        result.input = inputs[i];
+        result.output = getOutputFile(inputs[i]);
+        
+        if(claimedOutputs.contains(result.output))
+            result.error = "output name already used by another input";
+        else if(result.output != inputs[i] && inputs.contains(result.output))
+            result.error = "output would overwrite another input";
+        else {
+            claimedOutputs.add(result.output);
+            toRender.add(i);
+        }
+    }
+    
+    if(toRender.isEmpty())
+        return results;
+    
+    remainingJobs.store(toRender.size());
+    jobsFinished.reset();
+    
+    for(auto i : toRender)
+        pool.addJob(new RenderJob(*this, inputs[i], results.getReference(i)), true);
+    
+    jobsFinished.wait();
+    
+    return results;
+}
+
+juce::File BatchRenderer::getOutputFile(const juce::File& input) const
+{
+    auto directory = options.outputDirectory == juce::File() ? input.getParentDirectory() : options.outputDirectory;
+    return directory.getChildFile(input.getFileNameWithoutExtension() + options.suffix + input.getFileExtension());
+}
+
+static int chooseBitDepth(juce::AudioFormat& format, int sourceBitDepth)
+{
+    auto bitDepths = format.getPossibleBitDepths();
+    
+    if(bitDepths.contains(sourceBitDepth))
+        return sourceBitDepth;
+    
+    return bitDepths.isEmpty() ? 16 : bitDepths.getLast();
+}
+
+template <typename Chain>
+static juce::String filterFile(Chain& chain, const BatchRenderer::Options& options, juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer)
+{
+    const auto numChannels = (int) reader.numChannels;
+    const auto channelMode = numChannels == 2 ? options.channelMode : ChannelMode_Linked;
+    const auto independent = channelMode != ChannelMode_Linked && !(options.settings[1] == options.settings[0]);
+    
+    std::array<ChainCoefficients, numChannelSets> coefficients;
+    makeChainCoefficients(coefficients[0], options.settings[0], reader.sampleRate);
+    
+    chain.prepare(numChannels);
+    chain.setMidSide(channelMode == ChannelMode_MidSide);
+    
+    if(independent) {
+        makeChainCoefficients(coefficients[1], options.settings[1], reader.sampleRate);
+        chain.setCoefficients(coefficients[0], coefficients[1]);
+    }
+    else {
+        chain.setCoefficients(coefficients[0]);
+    }
+    
+    juce::AudioBuffer<float> buffer(numChannels, options.blockSize);
+    
+    for(juce::int64 position = 0; position < reader.lengthInSamples; position += options.blockSize) {
+        const auto numSamples = (int) juce::jmin((juce::int64) options.blockSize, reader.lengthInSamples - position);
+        
+        reader.read(&buffer, 0, numSamples, position, true, true);
+        chain.process(buffer.getArrayOfWritePointers(), numChannels, 0, numSamples);
+        
+        if(!writer.writeFromAudioSampleBuffer(buffer, 0, numSamples))
+            return "write failed";
+    }
+    
+    return {};
+}
+
+BatchRenderer::Result BatchRenderer::renderFile(const juce::File& input)
+{
+    Result result;
+    result.input = input;
+    result.output = getOutputFile(input);
+    
+    auto* format = formatManager.findFormatForFileExtension(input.getFileExtension());
+    
+    if(format == nullptr) {
+        result.error = "unsupported file type";
+        return result;
+    }
+    
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    
+    //WAV can be read straight out of a mapped file instead of through stream copies
+    if(auto* wav = dynamic_cast<juce::WavAudioFormat*>(format)) {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(wav->createMemoryMappedReader(input));
+        
+        if(mapped != nullptr && mapped->mapEntireFile())
+            reader = std::move(mapped);
+    }
+    
+    if(reader == nullptr)
+        reader.reset(formatManager.createReaderFor(input));
+    
+    if(reader == nullptr) {
+        result.error = "could not open input";
+        return result;
+    }
+    
+    if(result.output == input) {
+        result.error = "output would overwrite input";
+        return result;
+    }
+    
+    const auto numChannels = (int) reader->numChannels;
+    
+    result.output.deleteFile();
+    auto stream = result.output.createOutputStream();
+    
+    if(stream == nullptr) {
+        result.error = "could not create output";
+        return result;
+    }
+    
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(),
+                                                                            reader->sampleRate,
+                                                                            (unsigned int) numChannels,
+                                                                            chooseBitDepth(*format, (int) reader->bitsPerSample),
+                                                                            reader->metadataValues,
+                                                                            0));
+    
+    if(writer == nullptr) {
+        result.error = "format cannot be written";
+        return result;
+    }
+    
+    stream.release();
+    
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+    
+    if(options.stateVariable) {
+        SIMDStateVariableChain chain;
+        result.error = filterFile(chain, options, *reader, *writer);
+    }
+    else {
+        SIMDChain chain;
+        result.error = filterFile(chain, options, *reader, *writer);
+    }
+    
+    if(result.error.isNotEmpty())
+        return result;
+    
+    result.numFrames = reader->lengthInSamples;
+    result.numChannels = numChannels;
+    result.sampleRate = reader->sampleRate;
+    result.seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    
+    return result;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <JuceHeader.h>
+#include "../../Source/FilterChain.h"
+
+//Renders audio files through the FilterPlugin chain on a pool of worker threads.
+//Each file is streamed in large blocks (WAV inputs are memory mapped), filtered
+//with a SIMDChain (or its state variable form) and written next to its siblings in the output directory.
+//Only the chain runs, at the file's rate: oversampling, linear phase and the dynamic peak are not rendered.
+class BatchRenderer
+{
+public:
+    struct Options {
+        //left/mid and right/side; stereo files only use the second set when the mode asks for it
+        std::array<ChainSettings, numChannelSets> settings;
+        ChannelMode channelMode { ChannelMode_Linked };
+        bool stateVariable { false };
+        juce::File outputDirectory;
+        juce::String suffix { "_filtered" };
+        int blockSize { 65536 };
+        int numThreads { juce::SystemStats::getNumCpus() };
+    };
+
+    struct Result {
+        juce::File input, output;
+        juce::String error;
+        juce::int64 numFrames { 0 };
+        int numChannels { 0 };
+        double sampleRate { 0.0 };
+        double seconds { 0.0 };
+    };
+
+    explicit BatchRenderer(const Options& options);
+    ~BatchRenderer();
+
+    //blocks until every file has been rendered; an input whose output name another input has
+    //already claimed, or whose output would replace another input, is not rendered
+    juce::Array<Result> render(const juce::Array<juce::File>& inputs);
+
+private:
+    class RenderJob;
+
+    Result renderFile(const juce::File& input);
+    juce::File getOutputFile(const juce::File& input) const;
+
+    Options options;
+    juce::AudioFormatManager formatManager;
+    juce::ThreadPool pool;
+    //jobs of the current render still running; the last one to finish signals jobsFinished
+    std::atomic<int> remainingJobs { 0 };
+    juce::WaitableEvent jobsFinished;
+
+    JUCE_DECLARE_NON_COPYABLE(BatchRenderer)
+};
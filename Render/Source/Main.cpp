@@ -0,0 +1,142 @@
+#include <JuceHeader.h>
+#include "../../Source/PluginState.h"
+#include "BatchRenderer.h"
+
+#include <iostream>
+
+static void printUsage()
+{
+    std::cout << "usage: FilterRender --preset=<state file> [options] <audio files or folders>\n"
+                 "\n"
+                 "  --preset=<file>    state blob saved by FilterPlugin (getStateInformation format)\n"
+                 "  --out=<folder>     where rendered files go (default: next to each input)\n"
+                 "  --suffix=<text>    appended to each output file name (default: _filtered)\n"
+                 "  --block=<samples>  samples per channel read and processed at once (default: 65536)\n"
+                 "  --threads=<n>      files rendered in parallel (default: number of CPUs)\n"
+                 "  --ignore-unsupported\n"
+                 "                     render a preset using oversampling, linear phase or the dynamic peak\n"
+                 "                     with the static chain alone instead of failing\n";
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    if(args.size() == 0 || args.containsOption("--help|-h")) {
+        printUsage();
+        return 0;
+    }
+
+    const auto presetPath = args.getValueForOption("--preset");
+    juce::MemoryBlock presetData;
+
+    if(presetPath.isEmpty() || !juce::File::getCurrentWorkingDirectory().getChildFile(presetPath).loadFileAsData(presetData)) {
+        std::cerr << "could not read preset \"" << presetPath << "\"\n";
+        return 1;
+    }
+
+    BatchRenderer::Options options;
+    ProcessingSettings processing;
+
+    if(!loadChainSettings(presetData.getData(), (int) presetData.getSize(), options.settings, options.channelMode, processing)) {
+        std::cerr << "\"" << presetPath << "\" is not a FilterPlugin state\n";
+        return 1;
+    }
+
+    options.stateVariable = processing.stateVariable;
+
+    //only the chain is rendered, so the output would not match the plugin with any of these
+    juce::StringArray unsupported;
+
+    if(processing.oversamplingOrder > 0)
+        unsupported.add("Oversampling " + juce::String(1 << processing.oversamplingOrder) + "x");
+
+    if(processing.linearPhase)
+        unsupported.add("Phase Mode linear");
+
+    if(processing.dynamicPeak)
+        unsupported.add("Peak Ratio > 1 (dynamic peak)");
+
+    if(!unsupported.isEmpty()) {
+        const auto ignore = args.containsOption("--ignore-unsupported");
+        std::cerr << (ignore ? "warning: " : "") << "\"" << presetPath << "\" uses settings FilterRender does not render: "
+                  << unsupported.joinIntoString(", ") << "\n";
+
+        if(!ignore) {
+            std::cerr << "pass --ignore-unsupported to render the chain without them\n";
+            return 1;
+        }
+    }
+
+    if(args.containsOption("--out"))
+        options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--out"));
+
+    if(args.containsOption("--suffix"))
+        options.suffix = args.getValueForOption("--suffix");
+
+    if(args.containsOption("--block"))
+        options.blockSize = juce::jmax(64, args.getValueForOption("--block").getIntValue());
+
+    if(args.containsOption("--threads"))
+        options.numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    juce::Array<juce::File> inputs;
+
+    for(auto& arg : args.arguments) {
+        if(arg.isOption())
+            continue;
+
+        auto file = arg.resolveAsFile();
+
+        if(file.isDirectory())
+            inputs.addArray(file.findChildFiles(juce::File::findFiles, false, formatManager.getWildcardForAllFormats()));
+        else
+            inputs.add(file);
+    }
+
+    if(inputs.isEmpty()) {
+        printUsage();
+        return 1;
+    }
+
+    if(options.outputDirectory != juce::File())
+        options.outputDirectory.createDirectory();
+
+    BatchRenderer renderer(options);
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+    auto results = renderer.render(inputs);
+    const auto wallSeconds = juce::jmax(1.0e-9, (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001);
+
+    double totalSamples = 0.0, totalAudioSeconds = 0.0;
+    int numFailed = 0;
+
+    for(auto& result : results) {
+        if(result.error.isNotEmpty()) {
+            std::cerr << result.input.getFullPathName() << ": " << result.error << "\n";
+            numFailed++;
+            continue;
+        }
+
+        const auto samples = (double) result.numFrames * result.numChannels;
+        totalSamples += samples;
+        totalAudioSeconds += (double) result.numFrames / result.sampleRate;
+
+        std::cout << result.output.getFullPathName()
+                  << " samples_per_second=" << (juce::int64) (samples / juce::jmax(1.0e-9, result.seconds))
+                  << "\n";
+    }
+
+    std::cout << "files=" << (results.size() - numFailed)
+              << " failed=" << numFailed
+              << " threads=" << options.numThreads
+              << " seconds=" << wallSeconds
+              << " samples_per_second=" << (juce::int64) (totalSamples / wallSeconds)
+              << " realtime_factor=" << totalAudioSeconds / wallSeconds
+              << "\n";
+
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#include "AutomationEvents.h"
+
+AutomationEvents::AutomationEvents(juce::AudioProcessor& p) : processor(p)
+{
+    static_assert((capacity & (capacity - 1)) == 0, "the queue indexes with a mask");
+    
+    for(size_t i = 0; i < queue.size(); i++)
+        queue[i].sequence.store((juce::uint32) i, std::memory_order_relaxed);
+    
+    for(auto* parameter : processor.getParameters()) {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter);
+        
+        parameters.push_back(ranged);
+        chainParameters.push_back(ranged != nullptr ? ChainParameter::fromID(ranged->paramID) : ChainParameter());
+        
+        if(chainParameters.back().field != ChainParameter::None)
+            parameter->addListener(this);
+    }
+}
+
+AutomationEvents::~AutomationEvents()
+{
+    for(size_t i = 0; i < parameters.size(); i++)
+        if(chainParameters[i].field != ChainParameter::None)
+            parameters[i]->removeListener(this);
+}
+
+void AutomationEvents::parameterValueChanged(int parameterIndex, float newValue) {
+    
+    if(!ignoreListenerChanges.load())
+        add(parameterIndex, newValue, 0);
+}
+
+void AutomationEvents::add(int parameterIndex, float normalisedValue, int sampleOffset) noexcept {
+    
+    if(!juce::isPositiveAndBelow(parameterIndex, (int) parameters.size()) || chainParameters[(size_t) parameterIndex].field == ChainParameter::None)
+        return;
+    
+    const auto value = parameters[(size_t) parameterIndex]->convertFrom0to1(normalisedValue);
+    
+    auto position = writePosition.load(std::memory_order_relaxed);
+    
+    for(;;) {
+        auto& cell = queue[position & (capacity - 1)];
+        const auto difference = (juce::int32) (cell.sequence.load(std::memory_order_acquire) - position);
+        
+        //the reader has not taken the event written capacity positions ago: full, drop this one
+        if(difference < 0)
+            return;
+        
+        if(difference == 0 && writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            cell.event = { juce::jmax(0, sampleOffset), parameterIndex, value };
+            cell.sequence.store(position + 1, std::memory_order_release);
+            return;
+        }
+        
+        //another writer took the cell
+        if(difference > 0)
+            position = writePosition.load(std::memory_order_relaxed);
+    }
+}
+
+bool AutomationEvents::pop(Event& event) noexcept {
+    
+    auto& cell = queue[readPosition & (capacity - 1)];
+    
+    //empty, or a writer is still filling the cell; its event is taken with the next block
+    if(cell.sequence.load(std::memory_order_acquire) != readPosition + 1)
+        return false;
+    
+    event = cell.event;
+    cell.sequence.store(readPosition + capacity, std::memory_order_release);
+    readPosition++;
+    return true;
+}
+
+void AutomationEvents::collect(int numSamples, int oversamplingOrder) noexcept {
+    
+    numBlockEvents = nextBlockEvent = 0;
+    
+    //everything queued belongs to this block; late offsets are clamped into it
+    Event event;
+    
+    while(numBlockEvents < capacity && pop(event)) {
+        event.position = juce::jmax(0, juce::jmin(event.position, numSamples - 1)) << oversamplingOrder;
+        
+        //insertion keeps events with the same position in the order they arrived;
+        //the queue is nearly sorted already, so this rarely moves anything
+        auto index = numBlockEvents++;
+        
+        for(; index > 0 && blockEvents[(size_t) index - 1].position > event.position; index--)
+            blockEvents[(size_t) index] = blockEvents[(size_t) index - 1];
+        
+        blockEvents[(size_t) index] = event;
+    }
+}
+
+bool AutomationEvents::apply(int position, std::array<ChainSettings, numChannelSets>& settings, bool linked) noexcept {
+    
+    if(!hasEvents() || getNextPosition() > position)
+        return false;
+    
+    for(; hasEvents() && getNextPosition() <= position; nextBlockEvent++) {
+        const auto& event = blockEvents[(size_t) nextBlockEvent];
+        const auto& parameter = chainParameters[(size_t) event.parameterIndex];
+        
+        if(!linked)
+            parameter.apply(settings[(size_t) parameter.channelSet], event.value);
+        else if(parameter.channelSet == 0)
+            for(auto& set : settings)
+                parameter.apply(set, event.value);
+    }
+    
+    return true;
+}
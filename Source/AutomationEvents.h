@@ -0,0 +1,72 @@
+#pragma once
+#include <JuceHeader.h>
+#include "PluginState.h"
+
+//Timestamped changes of the chain parameters, handed to the audio thread without locks.
+//The parameter listeners queue every change at the start of the next block: JUCE's wrappers
+//apply host automation just before processBlock and pass on no sample offsets. Code that hosts
+//the processor directly and knows the offset of a change calls add() with it.
+//The audio thread collects the queue once per block and applies the events in order of
+//their offset while it runs the chain.
+class AutomationEvents : private juce::AudioProcessorParameter::Listener
+{
+public:
+    explicit AutomationEvents(juce::AudioProcessor& processor);
+    ~AutomationEvents() override;
+    
+    //any thread; parameterIndex as in AudioProcessor::getParameters(), the value normalised.
+    //Changes that do not fit the queue are dropped, the updater still brings the settings up to date.
+    void add(int parameterIndex, float normalisedValue, int sampleOffset) noexcept;
+    //message thread: drops the listeners' changes meanwhile, e.g. while a program is applied
+    void setIgnoringListenerChanges(bool shouldIgnore) noexcept { ignoreListenerChanges.store(shouldIgnore); }
+    
+    //audio thread: takes the queued events for a block of numSamples at the host rate;
+    //positions are then at the processing rate, numSamples << oversamplingOrder long
+    void collect(int numSamples, int oversamplingOrder) noexcept;
+    //audio thread: drops the block's events, e.g. in linear-phase mode
+    void clear() noexcept { numBlockEvents = nextBlockEvent = 0; }
+    
+    bool hasEvents() const noexcept { return nextBlockEvent < numBlockEvents; }
+    //position of the next event not yet applied, at the processing rate
+    int getNextPosition() const noexcept { return blockEvents[(size_t) nextBlockEvent].position; }
+    
+    //applies the events up to and including position; with linked channels the first set drives
+    //both and the second is ignored. Returns false if there was nothing to apply.
+    bool apply(int position, std::array<ChainSettings, numChannelSets>& settings, bool linked) noexcept;
+    
+    //a power of two
+    static constexpr int capacity = 1024;
+    
+private:
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override { }
+    
+    struct Event {
+        int position { 0 };
+        int parameterIndex { 0 };
+        float value { 0 };
+    };
+    
+    juce::AudioProcessor& processor;
+    std::atomic<bool> ignoreListenerChanges { false };
+    //indexed like the processor's parameters; None for everything the chain does not read
+    std::vector<ChainParameter> chainParameters;
+    std::vector<juce::RangedAudioParameter*> parameters;
+    
+    //Bounded queue with many writers (the message thread, the host's automation or audio thread)
+    //and the audio thread as its one reader, after Vyukov: a writer claims a cell by moving
+    //writePosition on, and the cell's sequence tells the reader when its event is complete
+    struct Cell {
+        std::atomic<juce::uint32> sequence { 0 };
+        Event event;
+    };
+    
+    std::array<Cell, capacity> queue;
+    std::atomic<juce::uint32> writePosition { 0 };
+    juce::uint32 readPosition { 0 };
+    
+    bool pop(Event& event) noexcept;
+    
+    std::array<Event, capacity> blockEvents;
+    int numBlockEvents { 0 }, nextBlockEvent { 0 };
+};
@@ -0,0 +1,333 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+//Plain second-order section, normalised so that a0 == 1.
+//Trivially copyable, so it can live in fixed arrays and be copied on the audio thread.
+//Kept in double: each processing path rounds to its own sample type (or topology) when
+//loading, so low cutoffs at high sample rates are not quantised before they get there.
+struct BiquadCoefficients
+{
+    double b0 { 1.0 }, b1 { 0.0 }, b2 { 0.0 }, a1 { 0.0 }, a2 { 0.0 };
+
+    double getMagnitudeForFrequency(double frequency, double sampleRate) const noexcept
+    {
+        const auto w = 2.0 * 3.14159265358979323846 * frequency / sampleRate;
+        const auto z1 = std::polar(1.0, -w);
+        const auto z2 = z1 * z1;
+
+        const auto numerator = b0 + b1 * z1 + b2 * z2;
+        const auto denominator = 1.0 + a1 * z1 + a2 * z2;
+
+        return std::abs(numerator / denominator);
+    }
+
+    //passes the signal through unchanged (e.g. a 0 dB peak), up to the rounding of the design
+    bool isNeutral() const noexcept
+    {
+        constexpr double tolerance = 1.0e-9;
+        return std::abs(b0 - 1.0) < tolerance && std::abs(b1 - a1) < tolerance && std::abs(b2 - a2) < tolerance;
+    }
+};
+
+//transposed direct form II, same topology as juce::dsp::IIR::Filter
+template<typename SampleType>
+struct BiquadState
+{
+    SampleType s1 { 0 }, s2 { 0 };
+
+    void reset() noexcept { s1 = s2 = 0; }
+};
+
+template<typename SampleType>
+inline SampleType processSample(const BiquadCoefficients& c, BiquadState<SampleType>& state, SampleType input) noexcept
+{
+    const auto b0 = (SampleType) c.b0, b1 = (SampleType) c.b1, b2 = (SampleType) c.b2;
+    const auto a1 = (SampleType) c.a1, a2 = (SampleType) c.a2;
+
+    const auto output = b0 * input + state.s1;
+    state.s1 = b1 * input - a1 * output + state.s2;
+    state.s2 = b2 * input - a2 * output;
+    return output;
+}
+
+//The same section as a trapezoidal (TPT) state variable filter, Andrew Simper's form:
+//  v1 = a1 ic1 + a2 (x - ic2),  v2 = ic2 + a2 ic1 + a3 (x - ic2),  y = m0 x + m1 v1 + m2 v2
+//The states are integrator outputs rather than differences of nearly equal products,
+//so float keeps its precision where a direct form with a1 -> -2, a2 -> 1 does not.
+struct StateVariableCoefficients
+{
+    double a1 { 1.0 }, a2 { 0.0 }, a3 { 0.0 }, m0 { 1.0 }, m1 { 0.0 }, m2 { 0.0 };
+};
+
+//Closed-form designers (RBJ cookbook, identical to juce::dsp::IIR::Coefficients).
+//They write into an existing object and never allocate.
+namespace BiquadDesign
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    inline void set(BiquadCoefficients& c, double b0, double b1, double b2, double a0, double a1, double a2) noexcept
+    {
+        const auto a0Inv = 1.0 / a0;
+        c.b0 = b0 * a0Inv;
+        c.b1 = b1 * a0Inv;
+        c.b2 = b2 * a0Inv;
+        c.a1 = a1 * a0Inv;
+        c.a2 = a2 * a0Inv;
+    }
+
+    //sine and cosine of the normalised angular frequency, all the RBJ designs need from the cutoff
+    struct Trig
+    {
+        double cosOmega { 1.0 }, sinOmega { 0.0 };
+
+        //from the prewarped frequency tan(omega / 2)
+        static Trig fromTanHalfOmega(double t) noexcept
+        {
+            const auto scale = 1.0 / (1.0 + t * t);
+            return { (1.0 - t * t) * scale, 2.0 * t * scale };
+        }
+    };
+
+    inline Trig getTrig(double sampleRate, double frequency) noexcept
+    {
+        const auto omega = 2.0 * pi * frequency / sampleRate;
+        return { std::cos(omega), std::sin(omega) };
+    }
+
+    inline double getTanHalfOmega(double sampleRate, double frequency) noexcept
+    {
+        return std::tan(pi * frequency / sampleRate);
+    }
+
+    inline void makePeak(BiquadCoefficients& c, const Trig& trig, double Q, double gainFactor) noexcept
+    {
+        const auto A = std::sqrt(gainFactor > 0.0 ? gainFactor : 0.0);
+        const auto alpha = trig.sinOmega / (Q * 2.0);
+        const auto c2 = -2.0 * trig.cosOmega;
+        const auto alphaTimesA = alpha * A;
+        const auto alphaOverA = alpha / A;
+
+        set(c, 1.0 + alphaTimesA, c2, 1.0 - alphaTimesA, 1.0 + alphaOverA, c2, 1.0 - alphaOverA);
+    }
+
+    inline void makePeak(BiquadCoefficients& c, double sampleRate, double frequency, double Q, double gainFactor) noexcept
+    {
+        makePeak(c, getTrig(sampleRate, frequency), Q, gainFactor);
+    }
+
+    //RBJ shelves, gainFactor is the linear gain of the shelf
+    inline void makeLowShelf(BiquadCoefficients& c, const Trig& trig, double Q, double gainFactor) noexcept
+    {
+        const auto A = std::sqrt(gainFactor > 0.0 ? gainFactor : 0.0);
+        const auto cosOmega = trig.cosOmega;
+        const auto beta = trig.sinOmega * std::sqrt(A) / Q;
+        const auto aPlus = A + 1.0, aMinus = A - 1.0;
+
+        set(c, A * (aPlus - aMinus * cosOmega + beta),
+               2.0 * A * (aMinus - aPlus * cosOmega),
+               A * (aPlus - aMinus * cosOmega - beta),
+               aPlus + aMinus * cosOmega + beta,
+               -2.0 * (aMinus + aPlus * cosOmega),
+               aPlus + aMinus * cosOmega - beta);
+    }
+
+    inline void makeLowShelf(BiquadCoefficients& c, double sampleRate, double frequency, double Q, double gainFactor) noexcept
+    {
+        makeLowShelf(c, getTrig(sampleRate, frequency), Q, gainFactor);
+    }
+
+    inline void makeHighShelf(BiquadCoefficients& c, const Trig& trig, double Q, double gainFactor) noexcept
+    {
+        const auto A = std::sqrt(gainFactor > 0.0 ? gainFactor : 0.0);
+        const auto cosOmega = trig.cosOmega;
+        const auto beta = trig.sinOmega * std::sqrt(A) / Q;
+        const auto aPlus = A + 1.0, aMinus = A - 1.0;
+
+        set(c, A * (aPlus + aMinus * cosOmega + beta),
+               -2.0 * A * (aMinus + aPlus * cosOmega),
+               A * (aPlus + aMinus * cosOmega - beta),
+               aPlus - aMinus * cosOmega + beta,
+               2.0 * (aMinus - aPlus * cosOmega),
+               aPlus - aMinus * cosOmega - beta);
+    }
+
+    inline void makeHighShelf(BiquadCoefficients& c, double sampleRate, double frequency, double Q, double gainFactor) noexcept
+    {
+        makeHighShelf(c, getTrig(sampleRate, frequency), Q, gainFactor);
+    }
+
+    inline void makeNotch(BiquadCoefficients& c, const Trig& trig, double Q) noexcept
+    {
+        const auto alpha = trig.sinOmega / (Q * 2.0);
+        const auto c2 = -2.0 * trig.cosOmega;
+
+        set(c, 1.0, c2, 1.0, 1.0 + alpha, c2, 1.0 - alpha);
+    }
+
+    inline void makeNotch(BiquadCoefficients& c, double sampleRate, double frequency, double Q) noexcept
+    {
+        makeNotch(c, getTrig(sampleRate, frequency), Q);
+    }
+
+    //RBJ band pass with 0 dB at the centre frequency
+    inline void makeBandPass(BiquadCoefficients& c, const Trig& trig, double Q) noexcept
+    {
+        const auto alpha = trig.sinOmega / (Q * 2.0);
+
+        set(c, alpha, 0.0, -alpha, 1.0 + alpha, -2.0 * trig.cosOmega, 1.0 - alpha);
+    }
+
+    inline void makeBandPass(BiquadCoefficients& c, double sampleRate, double frequency, double Q) noexcept
+    {
+        makeBandPass(c, getTrig(sampleRate, frequency), Q);
+    }
+
+    //Butterworth sections from the prewarped cutoff tan(omega / 2)
+    inline void makeHighPassFromTan(BiquadCoefficients& c, double tanHalfOmega, double Q) noexcept
+    {
+        const auto n = tanHalfOmega;
+        const auto nSquared = n * n;
+        const auto invQ = 1.0 / Q;
+        const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        set(c, c1, c1 * -2.0, c1, 1.0, c1 * 2.0 * (nSquared - 1.0), c1 * (1.0 - invQ * n + nSquared));
+    }
+
+    inline void makeHighPass(BiquadCoefficients& c, double sampleRate, double frequency, double Q) noexcept
+    {
+        makeHighPassFromTan(c, getTanHalfOmega(sampleRate, frequency), Q);
+    }
+
+    inline void makeLowPassFromTan(BiquadCoefficients& c, double tanHalfOmega, double Q) noexcept
+    {
+        const auto n = 1.0 / tanHalfOmega;
+        const auto nSquared = n * n;
+        const auto invQ = 1.0 / Q;
+        const auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        set(c, c1, c1 * 2.0, c1, 1.0, c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - invQ * n + nSquared));
+    }
+
+    inline void makeLowPass(BiquadCoefficients& c, double sampleRate, double frequency, double Q) noexcept
+    {
+        makeLowPassFromTan(c, getTanHalfOmega(sampleRate, frequency), Q);
+    }
+
+    //Q of section `index` in an even-order Butterworth cascade
+    inline double butterworthQ(int index, int order) noexcept
+    {
+        return 1.0 / (2.0 * std::cos((2.0 * index + 1.0) * pi / (order * 2.0)));
+    }
+
+    //Matched designs after Vicanek, "Matched Second Order Digital Filters" (2016). The poles are
+    //the analog ones mapped by z = e^(s T), the zeros are solved so the magnitude equals the analog
+    //prototype's at DC, at Nyquist and at the cutoff: no cramping near Nyquist and, unlike
+    //oversampling, no latency. omega is the normalised angular cutoff, 2 pi f / fs.
+    struct MatchedTerms
+    {
+        double a1 { 0.0 }, a2 { 0.0 };
+        //squared magnitudes of the denominator at DC and Nyquist, and its cross term
+        double A0 { 1.0 }, A1 { 1.0 }, A2 { 0.0 };
+        //cos^2, sin^2 of omega / 2 and 4 times their product
+        double phi0 { 1.0 }, phi1 { 0.0 }, phi2 { 0.0 };
+    };
+
+    inline MatchedTerms getMatchedTerms(double omega, double Q) noexcept
+    {
+        MatchedTerms t;
+        const auto zeta = 0.5 / Q;
+        const auto decay = std::exp(-zeta * omega);
+
+        //overdamped poles are real, their cosine becomes a hyperbolic one
+        t.a1 = zeta <= 1.0 ? -2.0 * decay * std::cos(std::sqrt(1.0 - zeta * zeta) * omega)
+                           : -2.0 * decay * std::cosh(std::sqrt(zeta * zeta - 1.0) * omega);
+        t.a2 = decay * decay;
+
+        t.A0 = (1.0 + t.a1 + t.a2) * (1.0 + t.a1 + t.a2);
+        t.A1 = (1.0 - t.a1 + t.a2) * (1.0 - t.a1 + t.a2);
+        t.A2 = -4.0 * t.a2;
+
+        const auto s = std::sin(omega * 0.5);
+        t.phi1 = s * s;
+        t.phi0 = 1.0 - t.phi1;
+        t.phi2 = 4.0 * t.phi0 * t.phi1;
+        return t;
+    }
+
+    inline double getMatchedOmega(double sampleRate, double frequency) noexcept
+    {
+        return 2.0 * pi * frequency / sampleRate;
+    }
+
+    //same prototype as makePeak, (s^2 + s A / Q + 1) / (s^2 + s / (A Q) + 1)
+    inline void makeMatchedPeak(BiquadCoefficients& c, double omega, double Q, double gainFactor) noexcept
+    {
+        const auto G = gainFactor > 0.0 ? gainFactor : 0.0;
+        //Vicanek writes the peak as (s^2 + s G / Q' + 1) / (s^2 + s / Q' + 1), Q' = A Q
+        const auto t = getMatchedTerms(omega, Q * std::sqrt(G));
+
+        const auto R1 = (t.A0 * t.phi0 + t.A1 * t.phi1 + t.A2 * t.phi2) * G * G;
+        const auto R2 = (t.A1 - t.A0 + 4.0 * (t.phi0 - t.phi1) * t.A2) * G * G;
+
+        const auto B0 = t.A0;
+        const auto B2 = (R1 - R2 * t.phi1 - B0) / (4.0 * t.phi1 * t.phi1);
+        const auto B1 = R2 + B0 + 4.0 * (t.phi1 - t.phi0) * B2;
+
+        const auto rootB0 = std::sqrt(B0), rootB1 = std::sqrt(std::max(B1, 0.0));
+        const auto W = 0.5 * (rootB0 + rootB1);
+        const auto b0 = 0.5 * (W + std::sqrt(std::max(W * W + B2, 0.0)));
+
+        c.b0 = b0;
+        c.b1 = 0.5 * (rootB0 - rootB1);
+        c.b2 = -B2 / (4.0 * b0);
+        c.a1 = t.a1;
+        c.a2 = t.a2;
+    }
+
+    inline void makeMatchedHighPass(BiquadCoefficients& c, double omega, double Q) noexcept
+    {
+        const auto t = getMatchedTerms(omega, Q);
+        const auto b0 = Q * std::sqrt(t.A0 * t.phi0 + t.A1 * t.phi1 + t.A2 * t.phi2) / (4.0 * t.phi1);
+
+        set(c, b0, -2.0 * b0, b0, 1.0, t.a1, t.a2);
+    }
+
+    inline void makeMatchedLowPass(BiquadCoefficients& c, double omega, double Q) noexcept
+    {
+        const auto t = getMatchedTerms(omega, Q);
+        const auto R1 = (t.A0 * t.phi0 + t.A1 * t.phi1 + t.A2 * t.phi2) * Q * Q;
+        const auto B0 = t.A0;
+        const auto B1 = (R1 - B0 * t.phi0) / t.phi1;
+
+        const auto b0 = 0.5 * (std::sqrt(B0) + std::sqrt(std::max(B1, 0.0)));
+        set(c, b0, std::sqrt(B0) - b0, 0.0, 1.0, t.a1, t.a2);
+    }
+
+    //Exact conversion of a stable biquad. Both are the bilinear transform of
+    //(n2 s^2 + n1 s + n0) / (s^2 + k s + 1) with s = (1 - z^-1) / (g (1 + z^-1)),
+    //so g, k and the numerator are recovered from the biquad and mixed from the SVF outputs.
+    inline StateVariableCoefficients toStateVariable(const BiquadCoefficients& c) noexcept
+    {
+        //1 + a1 + a2 = 4 g^2 / d0 and 1 - a1 + a2 = 4 / d0, d0 = 1 + k g + g^2
+        const auto d0 = 4.0 / (1.0 - c.a1 + c.a2);
+        const auto gSquared = std::max((1.0 + c.a1 + c.a2) * d0 * 0.25, 1.0e-24);
+        const auto g = std::sqrt(gSquared);
+        const auto k = d0 * (1.0 - c.a2) / (2.0 * g);
+
+        const auto B0 = c.b0 * d0, B1 = c.b1 * d0, B2 = c.b2 * d0;
+        const auto n2 = (B0 - B1 + B2) * 0.25;
+        const auto n1 = (B0 - B2) / (2.0 * g);
+        const auto n0 = (B0 + B1 + B2) / (4.0 * gSquared);
+
+        StateVariableCoefficients sv;
+        sv.a1 = 1.0 / (1.0 + g * (g + k));
+        sv.a2 = g * sv.a1;
+        sv.a3 = g * sv.a2;
+        sv.m0 = n2;
+        sv.m1 = n1 - n2 * k;
+        sv.m2 = n0 - n2;
+        return sv;
+    }
+}
@@ -0,0 +1,165 @@
+#include "ChainSmoother.h"
+
+void ChainSmoother::prepare(double sampleRate, double rampLengthInSeconds, const ChainSettings& initialSettings) noexcept {
+
+    for(auto* value : { &lowCutFreq, &highCutFreq, &peakFreq, &peakQuality })
+        value->reset(sampleRate, rampLengthInSeconds);
+
+    peakGain.reset(sampleRate, rampLengthInSeconds);
+
+    current = initialSettings;
+    switchLength = juce::roundToInt(sampleRate * stageFadeTime);
+
+    for(int k = 0; k < maxBands; k++) {
+        auto& band = bands[k];
+        const auto& settings = current.bands[k];
+
+        band.freq.reset(sampleRate, rampLengthInSeconds);
+        band.quality.reset(sampleRate, rampLengthInSeconds);
+        band.gain.reset(sampleRate, rampLengthInSeconds);
+
+        band.freq.setCurrentAndTargetValue(settings.freq);
+        band.quality.setCurrentAndTargetValue(settings.quality);
+        band.gain.setCurrentAndTargetValue(settings.gainInDecibels);
+        band.target = settings;
+        band.switching = false;
+    }
+
+    lowCutFreq.setCurrentAndTargetValue(current.lowCutFreq);
+    highCutFreq.setCurrentAndTargetValue(current.highCutFreq);
+    peakFreq.setCurrentAndTargetValue(current.peakFreq);
+    peakQuality.setCurrentAndTargetValue(current.peakQuality);
+    peakGain.setCurrentAndTargetValue(current.peakGainInDecibels);
+}
+
+void ChainSmoother::setTarget(const ChainSettings& target) noexcept {
+
+    lowCutFreq.setTargetValue(target.lowCutFreq);
+    highCutFreq.setTargetValue(target.highCutFreq);
+    peakFreq.setTargetValue(target.peakFreq);
+    peakQuality.setTargetValue(target.peakQuality);
+    peakGain.setTargetValue(target.peakGainInDecibels);
+
+    current.lowCutSlope = target.lowCutSlope;
+    current.highCutSlope = target.highCutSlope;
+    current.designMode = target.designMode;
+
+    for(int k = 0; k < maxBands; k++)
+        setBandTarget(k, target.bands[k]);
+}
+
+bool ChainSmoother::hasGain(BandType type) noexcept {
+
+    return type == BandType_Peak || type == BandType_LowShelf || type == BandType_HighShelf;
+}
+
+void ChainSmoother::setBandTarget(int k, const BandSettings& target) noexcept {
+
+    auto& band = bands[k];
+    const auto type = current.bands[k].type;
+    band.target = target;
+
+    //held off on the way to another type: the hold ends with whatever the target is by then
+    if(band.switching) {
+        band.switching = target.type != BandType_Off;
+        return;
+    }
+
+    //a band that is off has nothing to ramp from
+    if(type == BandType_Off) {
+        startBand(k);
+        return;
+    }
+
+    band.freq.setTargetValue(target.freq);
+    band.quality.setTargetValue(target.quality);
+
+    if(target.type == type) {
+        band.gain.setTargetValue(target.gainInDecibels);
+        return;
+    }
+
+    //leaving the type: a peak or shelf once its gain is back at 0 dB (see advance), anything else now
+    if(hasGain(type))
+        band.gain.setTargetValue(0.0f);
+
+    if(!hasGain(type) || !band.gain.isSmoothing())
+        leaveType(k);
+}
+
+void ChainSmoother::startBand(int k) noexcept {
+
+    auto& band = bands[k];
+    auto& settings = current.bands[k];
+    const auto& target = band.target;
+
+    band.switching = false;
+    band.freq.setCurrentAndTargetValue(target.freq);
+    band.quality.setCurrentAndTargetValue(target.quality);
+    band.gain.setCurrentAndTargetValue(hasGain(target.type) ? 0.0f : target.gainInDecibels);
+    band.gain.setTargetValue(target.gainInDecibels);
+
+    settings.type = target.type;
+    settings.freq = target.freq;
+    settings.quality = target.quality;
+    settings.gainInDecibels = band.gain.getCurrentValue();
+}
+
+void ChainSmoother::leaveType(int k) noexcept {
+
+    auto& band = bands[k];
+    auto& type = current.bands[k].type;
+
+    //a peak or shelf at 0 dB is neutral, so it can become another one as it is
+    if(hasGain(type) && hasGain(band.target.type)) {
+        startBand(k);
+        return;
+    }
+
+    type = BandType_Off;
+    band.switching = band.target.type != BandType_Off;
+    band.switchRemaining = switchLength;
+}
+
+bool ChainSmoother::isSmoothing() const noexcept {
+
+    return lowCutFreq.isSmoothing()
+        || highCutFreq.isSmoothing()
+        || peakFreq.isSmoothing()
+        || peakQuality.isSmoothing()
+        || peakGain.isSmoothing()
+        || std::any_of(bands.begin(), bands.end(), [](const BandSmoother& band) {
+               return band.switching || band.freq.isSmoothing() || band.quality.isSmoothing() || band.gain.isSmoothing();
+           });
+}
+
+const ChainSettings& ChainSmoother::advance(int numSamples) noexcept {
+
+    current.lowCutFreq = lowCutFreq.skip(numSamples);
+    current.highCutFreq = highCutFreq.skip(numSamples);
+    current.peakFreq = peakFreq.skip(numSamples);
+    current.peakQuality = peakQuality.skip(numSamples);
+    current.peakGainInDecibels = peakGain.skip(numSamples);
+
+    for(int k = 0; k < maxBands; k++) {
+        auto& band = bands[k];
+        auto& settings = current.bands[k];
+
+        //the hold counts the samples already run as Off, so the chain has finished the fade out
+        if(band.switching) {
+            if(band.switchRemaining <= 0)
+                startBand(k);
+            else
+                band.switchRemaining -= numSamples;
+        }
+
+        settings.freq = band.freq.skip(numSamples);
+        settings.quality = band.quality.skip(numSamples);
+        settings.gainInDecibels = band.gain.skip(numSamples);
+
+        if(settings.type != BandType_Off && settings.type != band.target.type && !band.gain.isSmoothing())
+            leaveType(k);
+    }
+
+    return current;
+}
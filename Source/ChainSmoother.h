@@ -0,0 +1,48 @@
+#pragma once
+#include <JuceHeader.h>
+#include "FilterChain.h"
+
+//Ramps the continuous ChainSettings values towards their targets.
+//Frequencies and Q ramp multiplicatively (even speed per octave), gain ramps linearly in dB.
+//Slopes are discrete and switch immediately.
+//A peak or shelf band switched on starts at 0 dB and one switched off first ramps to 0 dB,
+//so the band comes and goes without a step, and at 0 dB one gain type turns into another.
+//Any other change of type goes through Off, held for the chain's stage fade (stageFadeTime):
+//the old filter fades out in the chain before the new one fades in.
+class ChainSmoother
+{
+public:
+    void prepare(double sampleRate, double rampLengthInSeconds, const ChainSettings& initialSettings) noexcept;
+
+    void setTarget(const ChainSettings& target) noexcept;
+    bool isSmoothing() const noexcept;
+
+    //moves the ramps forward and returns the settings reached
+    const ChainSettings& advance(int numSamples) noexcept;
+
+private:
+    using LogSmoothedValue = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+
+    LogSmoothedValue lowCutFreq, highCutFreq, peakFreq, peakQuality;
+    juce::SmoothedValue<float> peakGain;
+
+    struct BandSmoother
+    {
+        LogSmoothedValue freq, quality;
+        juce::SmoothedValue<float> gain;
+        BandSettings target;
+        //held off on the way to another type, for switchRemaining more samples
+        bool switching { false };
+        int switchRemaining { 0 };
+    };
+
+    std::array<BandSmoother, maxBands> bands;
+    int switchLength { 0 };
+
+    ChainSettings current;
+
+    static bool hasGain(BandType type) noexcept;
+    void setBandTarget(int band, const BandSettings& target) noexcept;
+    void startBand(int band) noexcept;
+    void leaveType(int band) noexcept;
+};
@@ -0,0 +1,310 @@
+#include "ChannelWorkers.h"
+#include <chrono>
+#include <climits>
+#include <thread>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+#if JUCE_LINUX || JUCE_ANDROID
+ #include <linux/futex.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+ #define FILTERPLUGIN_FUTEX 1
+#elif JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+ #pragma comment(lib, "Synchronization.lib")
+ #define FILTERPLUGIN_FUTEX 1
+#elif JUCE_MAC || JUCE_IOS
+ #include <mach/mach.h>
+ #define FILTERPLUGIN_MACH_SEMAPHORE 1
+#endif
+
+namespace
+{
+    void spinPause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && (defined (__arm64__) || defined (__aarch64__))
+        __asm__ __volatile__ ("yield");
+       #else
+        std::this_thread::yield();
+       #endif
+    }
+}
+
+//How sleeping workers are woken. The audio thread's side (wake) never blocks or takes a lock.
+class ChannelWorkers::WakeUp
+{
+public:
+   #if FILTERPLUGIN_FUTEX
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "the futex word must be a plain 32 bit integer");
+
+    //sleeps until the word no longer holds `value` (or spuriously)
+    void wait(std::atomic<std::uint32_t>& word, std::uint32_t value) noexcept
+    {
+       #if JUCE_WINDOWS
+        WaitOnAddress(&word, &value, sizeof(value), INFINITE);
+       #else
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+       #endif
+    }
+
+    void wake(std::atomic<std::uint32_t>& word, int) noexcept
+    {
+       #if JUCE_WINDOWS
+        WakeByAddressAll(&word);
+       #else
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+       #endif
+    }
+   #elif FILTERPLUGIN_MACH_SEMAPHORE
+    //semaphore_signal is a Mach trap that takes no user space lock, safe on a real-time thread
+    WakeUp() { semaphore_create(mach_task_self(), &semaphore, SYNC_POLICY_FIFO, 0); }
+    ~WakeUp() { semaphore_destroy(mach_task_self(), semaphore); }
+
+    //a signal sent before the worker got here is kept, and the wait returns at once
+    void wait(std::atomic<std::uint32_t>&, std::uint32_t) noexcept { semaphore_wait(semaphore); }
+
+    void wake(std::atomic<std::uint32_t>&, int numSleeping) noexcept
+    {
+        for(int i = 0; i < numSleeping; i++)
+            semaphore_signal(semaphore);
+    }
+
+   private:
+    semaphore_t semaphore { 0 };
+   #else
+    //nothing the audio thread could signal without a lock: sleepers poll, and a job that comes in
+    //meanwhile is run by whoever is awake
+    void wait(std::atomic<std::uint32_t>&, std::uint32_t) noexcept { juce::Thread::sleep(1); }
+    void wake(std::atomic<std::uint32_t>&, int) noexcept { }
+   #endif
+};
+
+class ChannelWorkers::Worker : public juce::Thread
+{
+public:
+    Worker(ChannelWorkers& o, int index) : juce::Thread("Channel Worker " + juce::String(index + 1)), owner(o) { }
+
+    void run() override { owner.workerLoop(*this); }
+
+   #if FILTERPLUGIN_AUDIO_WORKGROUPS
+    juce::WorkgroupToken workgroupToken;
+    int joinedWorkgroup { 0 };
+   #endif
+
+private:
+    ChannelWorkers& owner;
+};
+
+ChannelWorkers::ChannelWorkers() : wakeUp(std::make_unique<WakeUp>()) { }
+
+ChannelWorkers::~ChannelWorkers() {
+    const juce::ScopedLock lock(clientLock);
+    resize(0);
+}
+
+void ChannelWorkers::prepare(const void* client, int numWorkersWanted) {
+
+    const juce::ScopedLock lock(clientLock);
+
+    auto request = std::find_if(requests.begin(), requests.end(), [client](const auto& r) { return r.first == client; });
+
+    if(request == requests.end())
+        requests.emplace_back(client, numWorkersWanted);
+    else
+        request->second = numWorkersWanted;
+
+    int largest = 0;
+    for(const auto& r : requests)
+        largest = juce::jmax(largest, r.second);
+
+    resize(largest);
+}
+
+void ChannelWorkers::release(const void* client) {
+
+    const juce::ScopedLock lock(clientLock);
+
+    requests.erase(std::remove_if(requests.begin(), requests.end(), [client](const auto& r) { return r.first == client; }), requests.end());
+
+    int largest = 0;
+    for(const auto& r : requests)
+        largest = juce::jmax(largest, r.second);
+
+    resize(largest);
+}
+
+void ChannelWorkers::resize(int newNumWorkers) {
+
+    newNumWorkers = juce::jmax(0, newNumWorkers);
+
+    if(newNumWorkers == (int) workers.size())
+        return;
+
+    //other clients may be running jobs: new workers just join in, leaving ones finish the task they hold
+    if(newNumWorkers > (int) workers.size()) {
+        while((int) workers.size() < newNumWorkers) {
+            workers.push_back(std::make_unique<Worker>(*this, (int) workers.size()));
+
+           #if JUCE_MAJOR_VERSION >= 7
+            workers.back()->startRealtimeThread(juce::Thread::RealtimeOptions{});
+           #else
+            workers.back()->startThread(10);
+           #endif
+        }
+
+        numWorkers.store(newNumWorkers, std::memory_order_relaxed);
+        return;
+    }
+
+    numWorkers.store(newNumWorkers, std::memory_order_relaxed);
+
+    for(auto i = (size_t) newNumWorkers; i < workers.size(); i++)
+        workers[i]->signalThreadShouldExit();
+
+    //a worker on its way to sleep finds the sequence moved on; one already asleep may not be the one
+    //a signal reaches, so keep waking until every leaving worker has gone
+    for(int attempt = 0; attempt < 1000; attempt++) {
+        sequence.fetch_add(1, std::memory_order_seq_cst);
+        wakeUp->wake(sequence, (int) workers.size());
+
+        bool running = false;
+        for(auto i = (size_t) newNumWorkers; i < workers.size(); i++)
+            running = running || workers[i]->isThreadRunning();
+
+        if(!running)
+            break;
+
+        juce::Thread::sleep(1);
+    }
+
+    for(auto i = (size_t) newNumWorkers; i < workers.size(); i++)
+        workers[i]->stopThread(1000);
+
+    workers.resize((size_t) newNumWorkers);
+}
+
+#if FILTERPLUGIN_AUDIO_WORKGROUPS
+void ChannelWorkers::setWorkgroup(const juce::AudioWorkgroup& newWorkgroup) {
+
+    {
+        const juce::SpinLock::ScopedLockType lock(workgroupLock);
+        workgroup = newWorkgroup;
+    }
+
+    //the workers join on their next pass
+    workgroupGeneration.fetch_add(1, std::memory_order_release);
+}
+#endif
+
+void ChannelWorkers::runTasks(int numTasks, TaskFunction taskFunction, void* taskContext) noexcept {
+
+    jassert(numTasks < 0x10000);
+
+    if(numWorkers.load(std::memory_order_relaxed) == 0 || numTasks <= 1 || busy.exchange(true, std::memory_order_acquire)) {
+        for(int index = 0; index < numTasks; index++)
+            taskFunction(taskContext, index);
+
+        return;
+    }
+
+    //the previous job has finished, nobody reads these until the new one is published
+    function = taskFunction;
+    context = taskContext;
+    remaining.store(numTasks, std::memory_order_relaxed);
+
+    const auto generation = (job.load(std::memory_order_relaxed) >> 32) + 1;
+    job.store(generation << 32 | (std::uint64_t) numTasks << 16, std::memory_order_release);
+
+    //a worker counts itself asleep before it waits on the sequence, so one of the two sees the other
+    sequence.fetch_add(1, std::memory_order_seq_cst);
+
+    if(numSleeping.load(std::memory_order_seq_cst) > 0)
+        wakeUp->wake(sequence, numSleeping.exchange(0, std::memory_order_seq_cst));
+
+    while(runNextTask()) { }
+
+    //tasks the workers claimed and are still running
+    while(remaining.load(std::memory_order_acquire) > 0)
+        spinPause();
+
+    busy.store(false, std::memory_order_release);
+}
+
+bool ChannelWorkers::runNextTask() noexcept {
+
+    auto current = job.load(std::memory_order_acquire);
+    int index;
+
+    for(;;) {
+        index = (int) (current & 0xffff);
+
+        if(index >= (int) ((current >> 16) & 0xffff))
+            return false;
+
+        if(job.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            break;
+    }
+
+    //the job cannot finish, and so cannot be replaced, before this task has
+    function(context, index);
+    remaining.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void ChannelWorkers::workerLoop(Worker& worker) noexcept {
+
+    using Clock = std::chrono::steady_clock;
+    const auto spinTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(spinTimeSeconds));
+
+    while(!worker.threadShouldExit()) {
+       #if FILTERPLUGIN_AUDIO_WORKGROUPS
+        const auto generation = workgroupGeneration.load(std::memory_order_acquire);
+
+        if(generation != worker.joinedWorkgroup) {
+            juce::AudioWorkgroup current;
+
+            {
+                const juce::SpinLock::ScopedLockType lock(workgroupLock);
+                current = workgroup;
+            }
+
+            worker.workgroupToken.reset();
+
+            if(current)
+                current.join(worker.workgroupToken);
+
+            worker.joinedWorkgroup = generation;
+        }
+       #endif
+
+        const auto seen = sequence.load(std::memory_order_acquire);
+
+        while(runNextTask()) { }
+
+        //the pieces of one callback follow each other closely, so stay awake for the next
+        const auto spinEnd = Clock::now() + spinTime;
+
+        while(sequence.load(std::memory_order_acquire) == seen && !worker.threadShouldExit() && Clock::now() < spinEnd)
+            spinPause();
+
+        if(sequence.load(std::memory_order_acquire) != seen || worker.threadShouldExit())
+            continue;
+
+        numSleeping.fetch_add(1, std::memory_order_seq_cst);
+
+        if(sequence.load(std::memory_order_seq_cst) == seen)
+            wakeUp->wait(sequence, seen);
+    }
+
+   #if FILTERPLUGIN_AUDIO_WORKGROUPS
+    worker.workgroupToken.reset();
+   #endif
+}
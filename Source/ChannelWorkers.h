@@ -0,0 +1,83 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+//audio workgroups arrived in JUCE 7.0.7
+#if JUCE_VERSION >= 0x70007
+ #define FILTERPLUGIN_AUDIO_WORKGROUPS 1
+#else
+ #define FILTERPLUGIN_AUDIO_WORKGROUPS 0
+#endif
+
+//Real-time threads that run the channel groups of a block alongside the audio thread, shared by
+//every instance through a SharedResourcePointer. Tasks are claimed from one atomic word, lock-free.
+class ChannelWorkers
+{
+public:
+    ChannelWorkers();
+    ~ChannelWorkers();
+
+    //message thread, the client's audio stopped; the pool runs as many workers as the largest request
+    void prepare(const void* client, int numWorkers);
+    void release(const void* client);
+    int getNumWorkers() const noexcept { return numWorkers.load(std::memory_order_relaxed); }
+
+   #if FILTERPLUGIN_AUDIO_WORKGROUPS
+    //the host's audio workgroup, joined by the workers; the last one reported is used
+    void setWorkgroup(const juce::AudioWorkgroup& newWorkgroup);
+   #endif
+
+    //audio thread: task(index) for every index below numTasks; returns once all have finished
+    template<typename Task>
+    void run(int numTasks, Task& task) noexcept
+    {
+        runTasks(numTasks, [](void* context, int index) { (*static_cast<Task*>(context))(index); }, &task);
+    }
+
+    //samples per task below which blocks run serially by default, a guess rather than a measurement
+    static constexpr int defaultMinSamples = 256;
+
+private:
+    using TaskFunction = void (*)(void*, int);
+
+    class Worker;
+    class WakeUp;
+
+    //message thread only, under clientLock
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::pair<const void*, int>> requests;
+    juce::CriticalSection clientLock;
+    std::unique_ptr<WakeUp> wakeUp;
+
+    std::atomic<int> numWorkers { 0 };
+    //set while an instance's job runs; another instance processes serially meanwhile
+    std::atomic<bool> busy { false };
+    //generation << 32 | number of tasks << 16 | next task to claim
+    std::atomic<std::uint64_t> job { 0 };
+    //claimed or not, tasks of the current job that have not finished
+    std::atomic<int> remaining { 0 };
+    //bumped with every job, the word sleeping workers wait on
+    std::atomic<std::uint32_t> sequence { 0 };
+    //workers that went to sleep since the last wake-up; only ever too high, which costs a spurious wake
+    std::atomic<int> numSleeping { 0 };
+
+    //written before the job is published, read by whoever claims one of its tasks
+    TaskFunction function { nullptr };
+    void* context { nullptr };
+
+   #if FILTERPLUGIN_AUDIO_WORKGROUPS
+    juce::AudioWorkgroup workgroup;
+    juce::SpinLock workgroupLock;
+    std::atomic<int> workgroupGeneration { 0 };
+   #endif
+
+    //how long a worker keeps spinning for the next job before it goes to sleep
+    static constexpr double spinTimeSeconds { 50.0e-6 };
+
+    void resize(int newNumWorkers);
+    void runTasks(int numTasks, TaskFunction taskFunction, void* taskContext) noexcept;
+    bool runNextTask() noexcept;
+    void workerLoop(Worker& worker) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE (ChannelWorkers)
+};
@@ -0,0 +1,265 @@
+#include "CoefficientCache.h"
+#include <algorithm>
+#include <cstring>
+
+template<typename Value>
+static std::uint64_t getBits(Value value) noexcept {
+    
+    static_assert(sizeof(Value) <= sizeof(std::uint64_t), "");
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(Value));
+    return bits;
+}
+
+CoefficientCache::Set::Set() noexcept {
+    
+    for(int way = 0; way < numWays; way++) {
+        hashes[(size_t) way].store(0, std::memory_order_relaxed);
+        lastUsed[(size_t) way].store(0, std::memory_order_relaxed);
+    }
+}
+
+CoefficientCache::Key CoefficientCache::makeKey(double sampleRate, int type, int order, float frequency, float quality, float gain) noexcept {
+    return { getBits(sampleRate),
+             (std::uint64_t) (std::uint32_t) type | (std::uint64_t) (std::uint32_t) order << 32,
+             getBits(frequency) | getBits(quality) << 32,
+             getBits(gain) };
+}
+
+std::uint64_t CoefficientCache::getHash(const Key& key) noexcept {
+    
+    std::uint64_t hash = 0;
+    
+    //the high bits, which pick the set, depend on every bit of the key
+    for(auto word : key) {
+        hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 29;
+    }
+    
+    //0 marks an empty slot
+    return hash != 0 ? hash : 1;
+}
+
+template<typename Design>
+bool CoefficientCache::get(CutCoefficients& coefficients, const Key& key, Design&& design) noexcept {
+    
+    const auto hash = getHash(key);
+    
+    if(find(key, hash, coefficients))
+        return true;
+    
+    design(coefficients);
+    insert(key, hash, coefficients);
+    return false;
+}
+
+bool CoefficientCache::find(const Key& key, std::uint64_t hash, CutCoefficients& coefficients) noexcept {
+    
+    auto& set = sets[(size_t) ((hash >> 32) % numSets)];
+    constexpr auto keySize = std::tuple_size<Key>::value;
+    
+    for(int way = 0; way < numWays; way++) {
+        if(set.hashes[(size_t) way].load(std::memory_order_relaxed) != hash)
+            continue;
+        
+        auto& slot = set.slots[(size_t) way];
+        const auto sequence = slot.sequence.load(std::memory_order_acquire);
+        
+        //the hash may have been read mid-write too, the key and sequence checks settle it
+        if((sequence & 1) != 0)
+            continue;
+        
+        auto matches = true;
+        
+        for(size_t i = 0; i < keySize; i++)
+            matches = matches && slot.words[i].load(std::memory_order_relaxed) == key[i];
+        
+        if(!matches)
+            continue;
+        
+        //written straight into the result; a copy torn by a writer is a miss and gets designed over
+        const auto numStages = (int) std::min<std::uint64_t>(slot.words[keySize].load(std::memory_order_relaxed), maxCutStages);
+        const auto* word = &slot.words[keySize + 1];
+        
+        for(int stage = 0; stage < numStages; stage++) {
+            auto& c = coefficients.stages[(size_t) stage];
+            
+            for(auto* coefficient : { &c.b0, &c.b1, &c.b2, &c.a1, &c.a2 }) {
+                const auto bits = (word++)->load(std::memory_order_relaxed);
+                std::memcpy(coefficient, &bits, sizeof(double));
+            }
+        }
+        
+        //a writer that started since the first read invalidates the copy
+        std::atomic_thread_fence(std::memory_order_acquire);
+        
+        if(slot.sequence.load(std::memory_order_relaxed) != sequence)
+            return false;
+        
+        coefficients.numStages = numStages;
+        
+        //written only when it changes, so instances reading the same entries do not fight over its cache line
+        const auto now = clock.load(std::memory_order_relaxed);
+        
+        if(set.lastUsed[(size_t) way].load(std::memory_order_relaxed) != now)
+            set.lastUsed[(size_t) way].store(now, std::memory_order_relaxed);
+        
+        return true;
+    }
+    
+    return false;
+}
+
+void CoefficientCache::insert(const Key& key, std::uint64_t hash, const CutCoefficients& coefficients) noexcept {
+    
+    std::lock_guard<std::mutex> lock(writeLock);
+    
+    auto& set = sets[(size_t) ((hash >> 32) % numSets)];
+    constexpr auto keySize = std::tuple_size<Key>::value;
+    int victim = -1;
+    
+    //the writers hold the lock, so the slots can be read directly
+    for(int way = 0; way < numWays; way++) {
+        auto& slot = set.slots[(size_t) way];
+        const auto slotHash = set.hashes[(size_t) way].load(std::memory_order_relaxed);
+        
+        //another instance designed it meanwhile
+        if(slotHash == hash) {
+            auto matches = true;
+            
+            for(size_t i = 0; i < keySize; i++)
+                matches = matches && slot.words[i].load(std::memory_order_relaxed) == key[i];
+            
+            if(matches)
+                return;
+        }
+        
+        //an empty slot, or else the one used longest ago
+        const auto victimEmpty = victim >= 0 && set.hashes[(size_t) victim].load(std::memory_order_relaxed) == 0;
+        
+        if(victim < 0 || (!victimEmpty && (slotHash == 0 || set.lastUsed[(size_t) way].load(std::memory_order_relaxed) < set.lastUsed[(size_t) victim].load(std::memory_order_relaxed))))
+            victim = way;
+    }
+    
+    auto& slot = set.slots[(size_t) victim];
+    auto& slotHash = set.hashes[(size_t) victim];
+    
+    if(slotHash.load(std::memory_order_relaxed) != 0)
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    else
+        numEntries.fetch_add(1, std::memory_order_relaxed);
+    
+    const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    slotHash.store(hash, std::memory_order_relaxed);
+    
+    for(size_t i = 0; i < keySize; i++)
+        slot.words[i].store(key[i], std::memory_order_relaxed);
+    
+    slot.words[keySize].store((std::uint64_t) coefficients.numStages, std::memory_order_relaxed);
+    auto* word = &slot.words[keySize + 1];
+    
+    for(int stage = 0; stage < coefficients.numStages; stage++) {
+        const auto& c = coefficients.stages[(size_t) stage];
+        
+        for(auto coefficient : { c.b0, c.b1, c.b2, c.a1, c.a2 })
+            (word++)->store(getBits(coefficient), std::memory_order_relaxed);
+    }
+    
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    set.lastUsed[(size_t) victim].store(clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void CoefficientCache::makeChainCoefficients(ChainCoefficients& chainCoefficients, const ChainSettings& chainSettings, double sampleRate) noexcept {
+    
+    std::uint64_t numHits = 0, numLookups = 0;
+    
+    auto count = [&](bool hit) {
+        numHits += hit ? 1 : 0;
+        numLookups++;
+    };
+    
+    const auto designType = chainSettings.designMode == DesignMode_Matched ? (int) FilterType_Matched : 0;
+    
+    //neutral cuts have no stages and nothing to look up
+    if(isLowCutNeutral(chainSettings))
+        chainCoefficients.lowCut.numStages = 0;
+    else
+        count(get(chainCoefficients.lowCut, makeKey(sampleRate, designType + FilterType_LowCut, chainSettings.lowCutSlope, chainSettings.lowCutFreq, 0, 0),
+                  [&](CutCoefficients& cut) { makeLowCutFilter(cut, chainSettings, sampleRate); }));
+    
+    if(isHighCutNeutral(chainSettings))
+        chainCoefficients.highCut.numStages = 0;
+    else
+        count(get(chainCoefficients.highCut, makeKey(sampleRate, designType + FilterType_HighCut, chainSettings.highCutSlope, chainSettings.highCutFreq, 0, 0),
+                  [&](CutCoefficients& cut) { makeHighCutFilter(cut, chainSettings, sampleRate); }));
+    
+    CutCoefficients biquad;
+    
+    count(get(biquad, makeKey(sampleRate, designType + FilterType_Peak, 0, chainSettings.peakFreq, chainSettings.peakQuality, chainSettings.peakGainInDecibels),
+              [&](CutCoefficients& peak) { makePeakFilter(peak.stages[0], chainSettings, sampleRate); peak.numStages = 1; }));
+    chainCoefficients.peak = biquad.stages[0];
+    
+    //packed like makeBandFilters
+    auto& bands = chainCoefficients.bands;
+    bands.numBands = 0;
+    
+    for(int i = 0; i < maxBands; i++) {
+        const auto& bandSettings = chainSettings.bands[(size_t) i];
+        
+        if(bandSettings.type == BandType_Off)
+            continue;
+        
+        //notches and band passes have no gain, so they share entries across it
+        const auto hasGain = bandSettings.type != BandType_Notch && bandSettings.type != BandType_BandPass;
+        
+        count(get(biquad, makeKey(sampleRate, FilterType_Band + bandSettings.type, 0, bandSettings.freq, bandSettings.quality, hasGain ? bandSettings.gainInDecibels : 0.0f),
+                  [&](CutCoefficients& band) { makeBandFilter(band.stages[0], bandSettings, sampleRate); band.numStages = 1; }));
+        
+        if(!biquad.stages[0].isNeutral()) {
+            bands.stages[(size_t) bands.numBands] = biquad.stages[0];
+            bands.bandIndices[(size_t) bands.numBands++] = i;
+        }
+    }
+    
+    //one update of the shared counters per chain
+    hits.fetch_add(numHits, std::memory_order_relaxed);
+    misses.fetch_add(numLookups - numHits, std::memory_order_relaxed);
+}
+
+CoefficientCache::Statistics CoefficientCache::getStatistics() const noexcept {
+    
+    Statistics statistics;
+    statistics.hits = hits.load(std::memory_order_relaxed);
+    statistics.misses = misses.load(std::memory_order_relaxed);
+    statistics.evictions = evictions.load(std::memory_order_relaxed);
+    statistics.numEntries = numEntries.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+void CoefficientCache::clear() noexcept {
+    
+    std::lock_guard<std::mutex> lock(writeLock);
+    
+    for(auto& set : sets) {
+        for(int way = 0; way < numWays; way++) {
+            auto& slot = set.slots[(size_t) way];
+            
+            //readers see the sequence move and miss
+            if(set.hashes[(size_t) way].load(std::memory_order_relaxed) != 0) {
+                const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+                slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                set.hashes[(size_t) way].store(0, std::memory_order_relaxed);
+                slot.sequence.store(sequence + 2, std::memory_order_release);
+            }
+        }
+    }
+    
+    for(auto* counter : { &hits, &misses, &evictions })
+        counter->store(0, std::memory_order_relaxed);
+    
+    numEntries.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <tuple>
+#include "FilterChain.h"
+
+//Filter designs shared by every instance through juce::SharedResourcePointer<CoefficientCache>.
+//Lookups are lock-free, inserts lock, so not for the audio thread.
+class CoefficientCache
+{
+public:
+    void makeChainCoefficients(ChainCoefficients& chainCoefficients, const ChainSettings& chainSettings, double sampleRate) noexcept;
+    
+    struct Statistics
+    {
+        std::uint64_t hits { 0 }, misses { 0 }, evictions { 0 };
+        int numEntries { 0 };
+    };
+    
+    Statistics getStatistics() const noexcept;
+    //empties the cache and zeroes the counters, e.g. between benchmark runs
+    void clear() noexcept;
+    
+    static constexpr int numSets = 256, numWays = 8;
+    
+private:
+    enum FilterType {
+        FilterType_LowCut,
+        FilterType_HighCut,
+        FilterType_Peak,
+        //plus the BandType
+        FilterType_Band,
+        //added to the peak and cut types for their matched designs
+        FilterType_Matched = 0x100
+    };
+    
+    //sample rate, type and order, frequency and Q, gain, packed bitwise
+    using Key = std::array<std::uint64_t, 4>;
+    static Key makeKey(double sampleRate, int type, int order, float frequency, float quality, float gain) noexcept;
+    static std::uint64_t getHash(const Key& key) noexcept;
+    
+    static constexpr int coefficientsPerStage = 5;
+    //the key, the number of stages and the coefficients of each; single biquads use one stage
+    static constexpr size_t numWords = std::tuple_size<Key>::value + 1 + maxCutStages * coefficientsPerStage;
+    
+    struct Slot
+    {
+        //odd while written, only ever counts up
+        std::atomic<std::uint32_t> sequence { 0 };
+        //stored as words so readers racing a writer stay well defined
+        std::array<std::atomic<std::uint64_t>, numWords> words;
+    };
+    
+    //hashes and use stamps sit together, so a lookup touches only the slot that matches
+    struct Set
+    {
+        Set() noexcept;
+        
+        //0 while the slot is empty
+        alignas(64) std::array<std::atomic<std::uint64_t>, numWays> hashes;
+        std::array<std::atomic<std::uint64_t>, numWays> lastUsed;
+        std::array<Slot, numWays> slots;
+    };
+    
+    std::array<Set, numSets> sets;
+    std::mutex writeLock;
+    
+    //counts inserts; hits stamp their slot with it, which orders the slots closely enough for eviction
+    std::atomic<std::uint64_t> clock { 1 };
+    std::atomic<std::uint64_t> hits { 0 }, misses { 0 }, evictions { 0 };
+    std::atomic<int> numEntries { 0 };
+    
+    //the entry for key, designed and inserted on a miss; returns whether it was a hit
+    template<typename Design>
+    bool get(CutCoefficients& coefficients, const Key& key, Design&& design) noexcept;
+    bool find(const Key& key, std::uint64_t hash, CutCoefficients& coefficients) noexcept;
+    void insert(const Key& key, std::uint64_t hash, const CutCoefficients& coefficients) noexcept;
+};
@@ -0,0 +1,184 @@
+#include "CoefficientTable.h"
+#include "FilterChain.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+void CoefficientTable::prepare(int newSegmentsPerOctave) {
+
+    segmentsPerOctave = std::max(newSegmentsPerOctave, 0);
+
+    if(segmentsPerOctave == 0) {
+        std::vector<Segment>().swap(tangents);
+        std::vector<Segment>().swap(gains);
+        return;
+    }
+
+    tangents.resize((size_t) (numOctaves * segmentsPerOctave));
+
+    //evenly spaced in x within each octave; d tan(pi x) / dx = pi (1 + tan^2(pi x))
+    for(int octave = 0; octave < numOctaves; octave++) {
+        const auto octaveStart = std::ldexp(1.0, minOctave + octave);
+        const auto step = octaveStart / segmentsPerOctave;
+
+        for(int i = 0; i < segmentsPerOctave; i++) {
+            const auto x0 = octaveStart + i * step;
+            const auto t0 = std::tan(BiquadDesign::pi * x0), t1 = std::tan(BiquadDesign::pi * (x0 + step));
+
+            tangents[(size_t) (octave * segmentsPerOctave + i)] = makeSegment(t0, BiquadDesign::pi * (1.0 + t0 * t0) * step,
+                                                                              t1, BiquadDesign::pi * (1.0 + t1 * t1) * step);
+        }
+    }
+
+    const auto numGainSegments = (int) std::lround((maxGainInDecibels - minGainInDecibels) / gainStepInDecibels);
+    gains.resize((size_t) numGainSegments);
+
+    //d 10^(dB / 20) / d dB = 10^(dB / 20) ln(10) / 20
+    const auto slopeScale = std::log(10.0) * 0.05 * gainStepInDecibels;
+
+    for(int i = 0; i < numGainSegments; i++) {
+        const auto decibels = minGainInDecibels + i * gainStepInDecibels;
+        const auto g0 = std::pow(10.0, decibels * 0.05), g1 = std::pow(10.0, (decibels + gainStepInDecibels) * 0.05);
+        gains[(size_t) i] = makeSegment(g0, g0 * slopeScale, g1, g1 * slopeScale);
+    }
+}
+
+size_t CoefficientTable::getMemoryUsage() const noexcept {
+    return (tangents.capacity() + gains.capacity()) * sizeof(Segment);
+}
+
+CoefficientTable::Segment CoefficientTable::makeSegment(double value0, double slope0, double value1, double slope1) noexcept {
+    return { value0,
+             slope0,
+             3.0 * (value1 - value0) - 2.0 * slope0 - slope1,
+             2.0 * (value0 - value1) + slope0 + slope1 };
+}
+
+double CoefficientTable::lookUpTangent(double x) const noexcept {
+
+    //x = 2^exponent (1 + fraction): the exponent picks the octave, the fraction the place in it
+    std::uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+
+    const auto octave = (int) ((bits >> 52) & 0x7ff) - 1023 - minOctave;
+    const auto position = (double) (bits & ((std::uint64_t(1) << 52) - 1)) * (segmentsPerOctave / (double) (std::uint64_t(1) << 52));
+
+    //x == 1/4 lands one past the last segment, at its end
+    auto index = octave * segmentsPerOctave + (int) position;
+    auto p = position - (int) position;
+
+    if(index >= (int) tangents.size()) {
+        index = (int) tangents.size() - 1;
+        p = 1.0;
+    }
+
+    return tangents[(size_t) index].evaluate(p);
+}
+
+double CoefficientTable::getTanHalfOmega(double sampleRate, double frequency) const noexcept {
+
+    const auto x = frequency / sampleRate;
+
+    if(!isPrepared() || !(x >= minNormalisedFrequency && x <= 0.5 - minNormalisedFrequency))
+        return BiquadDesign::getTanHalfOmega(sampleRate, frequency);
+
+    //tan(pi x) = 1 / tan(pi (1/2 - x)), and 1/2 - x is exact here
+    return x <= 0.25 ? lookUpTangent(x) : 1.0 / lookUpTangent(0.5 - x);
+}
+
+BiquadDesign::Trig CoefficientTable::getTrig(double sampleRate, double frequency) const noexcept {
+
+    if(!isPrepared())
+        return BiquadDesign::getTrig(sampleRate, frequency);
+
+    return BiquadDesign::Trig::fromTanHalfOmega(getTanHalfOmega(sampleRate, frequency));
+}
+
+double CoefficientTable::getGainFactor(double gainInDecibels) const noexcept {
+
+    if(!isPrepared() || !(gainInDecibels >= minGainInDecibels && gainInDecibels < maxGainInDecibels))
+        return std::pow(10.0, gainInDecibels * 0.05);
+
+    const auto position = (gainInDecibels - minGainInDecibels) * (1.0 / gainStepInDecibels);
+    const auto index = (int) position;
+    return gains[(size_t) index].evaluate(position - index);
+}
+
+CoefficientTable::AccuracyReport CoefficientTable::measureAccuracy(double sampleRate, int numChains) const {
+
+    AccuracyReport report;
+
+    if(!isPrepared())
+        return report;
+
+    //between and on the table points
+    constexpr int numSweepPoints = 1 << 16;
+
+    for(int i = 0; i <= numSweepPoints; i++) {
+        const auto normalised = minNormalisedFrequency * std::pow(0.49 / minNormalisedFrequency, (double) i / numSweepPoints);
+        const auto direct = std::tan(BiquadDesign::pi * normalised);
+        report.maxTanError = std::max(report.maxTanError, std::abs(getTanHalfOmega(1.0, normalised) / direct - 1.0));
+
+        const auto decibels = minGainInDecibels + (maxGainInDecibels - minGainInDecibels) * i / numSweepPoints;
+        report.maxGainError = std::max(report.maxGainError, std::abs(getGainFactor(decibels) / std::pow(10.0, decibels * 0.05) - 1.0));
+    }
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    auto logUniform = [&](double low, double high) { return (float) (low * std::pow(high / low, unit(generator))); };
+
+    auto compare = [&](const BiquadCoefficients& a, const BiquadCoefficients& b) {
+        for(auto difference : { a.b0 - b.b0, a.b1 - b.b1, a.b2 - b.b2, a.a1 - b.a1, a.a2 - b.a2 })
+            report.maxCoefficientError = std::max(report.maxCoefficientError, std::abs(difference));
+    };
+
+    const auto maxFrequency = std::min(20000.0, sampleRate * 0.49);
+    ChainCoefficients direct, table;
+
+    for(int n = 0; n < numChains; n++) {
+        ChainSettings settings;
+        settings.lowCutFreq = logUniform(20.0, maxFrequency);
+        settings.highCutFreq = logUniform(20.0, maxFrequency);
+        settings.lowCutSlope = static_cast<Slope>(generator() % 4);
+        settings.highCutSlope = static_cast<Slope>(generator() % 4);
+        settings.peakFreq = logUniform(20.0, maxFrequency);
+        settings.peakGainInDecibels = (float) (unit(generator) * 48.0 - 24.0);
+        settings.peakQuality = logUniform(0.1, 10.0);
+
+        for(auto& band : settings.bands) {
+            band.type = static_cast<BandType>(generator() % 6);
+            band.freq = logUniform(20.0, maxFrequency);
+            band.gainInDecibels = (float) (unit(generator) * 48.0 - 24.0);
+            band.quality = logUniform(0.1, 10.0);
+        }
+
+        makeChainCoefficients(direct, settings, sampleRate);
+        makeChainCoefficients(table, settings, sampleRate, this);
+
+        compare(direct.peak, table.peak);
+
+        for(int i = 0; i < direct.lowCut.numStages; i++)
+            compare(direct.lowCut.stages[(size_t) i], table.lowCut.stages[(size_t) i]);
+
+        for(int i = 0; i < direct.highCut.numStages; i++)
+            compare(direct.highCut.stages[(size_t) i], table.highCut.stages[(size_t) i]);
+
+        for(int i = 0; i < std::min(direct.bands.numBands, table.bands.numBands); i++)
+            compare(direct.bands.stages[(size_t) i], table.bands.stages[(size_t) i]);
+
+        for(int i = 0; i < 64; i++) {
+            const auto frequency = 20.0 * std::pow(maxFrequency / 20.0, i / 63.0);
+            const auto reference = direct.getMagnitudeForFrequency(frequency, sampleRate);
+            
+            //deep in a stop band both are rounding noise
+            if(reference < 1.0e-6)
+                continue;
+            
+            const auto ratio = table.getMagnitudeForFrequency(frequency, sampleRate) / reference;
+            report.maxMagnitudeErrorInDecibels = std::max(report.maxMagnitudeErrorInDecibels, std::abs(20.0 * std::log10(ratio)));
+        }
+    }
+
+    return report;
+}
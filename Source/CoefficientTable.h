@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+#include "Biquad.h"
+
+struct ChainSettings;
+
+//Lookup tables for the parts of the designs that cost trigonometric or pow calls:
+//tan(pi f / fs) over the normalised frequency and the linear gain over decibels.
+//The frequency table has the same number of segments in every octave and is indexed straight from
+//the exponent and mantissa bits of f / fs, so a lookup needs no log; each segment holds the cubic
+//Hermite polynomial through its ends (values and exact derivatives), evaluated in three multiply-adds.
+//Above fs / 4 the tangent is taken as 1 / tan(pi (0.5 - f / fs)), which keeps the pole at fs / 2
+//out of the table. The frequency axis is normalised, so one table serves every sample rate and
+//oversampling factor, and Q only ever divides, so the designs stay exact in Q.
+//Lookups outside the tables (or from a table that is not prepared) fall back to the direct calls.
+class CoefficientTable
+{
+public:
+    //message thread, audio stopped; 0 frees the table and every lookup goes direct
+    void prepare(int segmentsPerOctave);
+
+    bool isPrepared() const noexcept { return !tangents.empty(); }
+    int getSegmentsPerOctave() const noexcept { return segmentsPerOctave; }
+    size_t getMemoryUsage() const noexcept;
+
+    double getTanHalfOmega(double sampleRate, double frequency) const noexcept;
+    BiquadDesign::Trig getTrig(double sampleRate, double frequency) const noexcept;
+    double getGainFactor(double gainInDecibels) const noexcept;
+
+    //table designs against the direct ones
+    struct AccuracyReport
+    {
+        //relative errors of the interpolated values
+        double maxTanError { 0 }, maxGainError { 0 };
+        //largest coefficient difference over randomised chains
+        double maxCoefficientError { 0 };
+        //largest difference of the chain response, 20 Hz - 20 kHz
+        double maxMagnitudeErrorInDecibels { 0 };
+    };
+
+    AccuracyReport measureAccuracy(double sampleRate, int numChains) const;
+
+    //octaves of f / fs in the frequency table, 2^-20 (20 Hz at 16 x 192 kHz is about 2^-17) up to 1/4
+    static constexpr int minOctave = -20, numOctaves = 18;
+    static constexpr double minNormalisedFrequency = 1.0 / (1 << -minOctave);
+    static constexpr double minGainInDecibels = -48.0, maxGainInDecibels = 48.0, gainStepInDecibels = 0.125;
+
+    static constexpr int defaultSegmentsPerOctave = 32;
+
+private:
+    //c0 + p (c1 + p (c2 + p c3)), p in [0, 1) across the segment
+    struct Segment {
+        double c0, c1, c2, c3;
+
+        double evaluate(double p) const noexcept { return c0 + p * (c1 + p * (c2 + p * c3)); }
+    };
+
+    //Hermite segment from the values and the derivatives (per segment length) at both ends
+    static Segment makeSegment(double value0, double slope0, double value1, double slope1) noexcept;
+
+    //tan(pi x) for x in [2^minOctave, 1/4]
+    double lookUpTangent(double normalisedFrequency) const noexcept;
+
+    std::vector<Segment> tangents, gains;
+    int segmentsPerOctave { 0 };
+};
@@ -0,0 +1,163 @@
+#include "DynamicPeak.h"
+
+void DynamicPeak::prepare(double newSampleRate, int maximumBlockSize) {
+
+    sampleRate = newSampleRate;
+
+    //the shortest update interval is one sample
+    gainChanges.assign((size_t) juce::jmax(1, maximumBlockSize), 0.0f);
+
+    setParameters(settings, band, decimation);
+    reset();
+}
+
+void DynamicPeak::reset() noexcept {
+
+    bandState = {};
+    envelope = 0;
+    decimatedSum = 0;
+    decimatedCount = 0;
+
+    std::fill(gainChanges.begin(), gainChanges.end(), 0.0f);
+    startGainChange = 0;
+    numGainChanges = 0;
+    numAnalysedSamples = 0;
+}
+
+int DynamicPeak::getDecimation(double sampleRate, float bandFrequency, float bandQuality) noexcept {
+
+    const auto halfBandwidth = 0.5 / juce::jmax(0.01, (double) bandQuality);
+    const auto upperEdge = bandFrequency * (std::sqrt(1.0 + halfBandwidth * halfBandwidth) + halfBandwidth);
+    int factor = 1;
+
+    //16 samples per cycle keep the sampled peak of the band within 0.2 dB of its crest
+    while(factor < maxDecimation && sampleRate / (factor * 2) >= juce::jmax(4.0 * upperEdge, 16.0 * bandFrequency))
+        factor *= 2;
+
+    return factor;
+}
+
+void DynamicPeak::setParameters(const DynamicSettings& newSettings, const BiquadCoefficients& detectorBand, int newDecimation) noexcept {
+
+    settings = newSettings;
+    band = detectorBand;
+
+    //the band state is kept across a new rate, only the partly collected sample is dropped
+    if(newDecimation != decimation) {
+        decimation = juce::jlimit(1, maxDecimation, newDecimation);
+        decimatedSum = 0;
+        decimatedCount = 0;
+    }
+
+    //one-pole smoothing, the envelope covers 1 - 1/e of a step in the given time
+    auto coefficient = [this](float milliseconds) {
+        return (float) std::exp(-1.0 / (juce::jmax(0.01, (double) milliseconds) * 0.001 * sampleRate));
+    };
+
+    attack = coefficient(settings.attackInMilliseconds);
+    release = coefficient(settings.releaseInMilliseconds);
+    intervalAttack = std::pow(attack, (float) analysedInterval);
+    intervalRelease = std::pow(release, (float) analysedInterval);
+}
+
+template<typename SampleType>
+void DynamicPeak::analyse(const SampleType* const* channels, int numChannels, int numSamples, int updateInterval, bool bandPass) noexcept {
+
+    if(updateInterval != analysedInterval) {
+        analysedInterval = juce::jmax(1, updateInterval);
+        intervalAttack = std::pow(attack, (float) analysedInterval);
+        intervalRelease = std::pow(release, (float) analysedInterval);
+    }
+
+    if(numGainChanges > 0)
+        startGainChange = gainChanges[(size_t) numGainChanges - 1];
+
+    numGainChanges = 0;
+    numAnalysedSamples = numSamples;
+
+    if(numChannels <= 0)
+        return;
+
+    //the sidechain is followed at the host rate
+    const auto step = bandPass ? decimation : 1;
+    const auto averageGain = 1.0f / (float) (numChannels * step);
+    const auto slope = 1.0f - 1.0f / juce::jmax(1.0f, settings.ratio);
+    const auto b0 = (float) band.b0, b1 = (float) band.b1, b2 = (float) band.b2;
+    const auto a1 = (float) band.a1, a2 = (float) band.a2;
+    auto x1 = bandState.x1, x2 = bandState.x2, y1 = bandState.y1, y2 = bandState.y2;
+    auto level = envelope;
+    auto sum = decimatedCount < step ? decimatedSum : 0.0f;
+    auto count = decimatedCount < step ? decimatedCount : 0;
+
+    for(int start = 0; start < numSamples; start += analysedInterval) {
+        const auto length = juce::jmin(analysedInterval, numSamples - start);
+        const auto end = start + length;
+        float peak = 0;
+        int i = start;
+
+        //each group of step samples is averaged into one band pass input, counted towards the
+        //interval it is completed in; the groups do not depend on each other, so they overlap
+        while(i + step - count <= end) {
+            const auto groupEnd = i + step - count;
+            auto x = sum;
+
+            for(int k = i; k < groupEnd; k++)
+                for(int ch = 0; ch < numChannels; ch++)
+                    x += (float) channels[ch][k];
+
+            x *= averageGain;
+            i = groupEnd;
+            sum = 0;
+            count = 0;
+
+            if(bandPass) {
+                const auto y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+                x2 = x1;
+                x1 = x;
+                y2 = y1;
+                y1 = y;
+                x = y;
+            }
+
+            peak = juce::jmax(peak, std::abs(x));
+        }
+
+        //the rest starts the next group
+        for(; i < end; i++, count++)
+            for(int ch = 0; ch < numChannels; ch++)
+                sum += (float) channels[ch][i];
+
+        //a short last interval gets its own coefficients
+        const auto full = length == analysedInterval;
+        const auto coefficient = peak > level ? (full ? intervalAttack : std::pow(attack, (float) length))
+                                              : (full ? intervalRelease : std::pow(release, (float) length));
+        level = peak + coefficient * (level - peak);
+
+        const auto over = juce::Decibels::gainToDecibels(level, -100.0f) - settings.thresholdInDecibels;
+
+        if(numGainChanges < (int) gainChanges.size())
+            gainChanges[(size_t) numGainChanges++] = over > 0 ? -juce::jmin(maxGainChange, over * slope) : 0.0f;
+    }
+
+    bandState = { x1, x2, y1, y2 };
+    envelope = level;
+    decimatedSum = sum;
+    decimatedCount = count;
+}
+
+template void DynamicPeak::analyse<float>(const float* const*, int, int, int, bool) noexcept;
+template void DynamicPeak::analyse<double>(const double* const*, int, int, int, bool) noexcept;
+
+float DynamicPeak::getGainChange(int sample) const noexcept {
+
+    if(numGainChanges == 0)
+        return startGainChange;
+
+    const auto interval = juce::jlimit(0, numGainChanges - 1, sample / analysedInterval);
+    const auto start = interval * analysedInterval;
+    const auto length = juce::jmax(1, juce::jmin(analysedInterval, numAnalysedSamples - start));
+    const auto from = interval > 0 ? gainChanges[(size_t) interval - 1] : startGainChange;
+    const auto position = juce::jlimit(0.0f, 1.0f, (float) (sample - start + 1) / (float) length);
+
+    return from + (gainChanges[(size_t) interval] - from) * position;
+}
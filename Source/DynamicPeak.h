@@ -0,0 +1,73 @@
+#pragma once
+#include <JuceHeader.h>
+#include "FilterChain.h"
+
+//the peak band follows "Peak Gain" while ratio is 1
+struct DynamicSettings {
+    float thresholdInDecibels { 0 }, ratio { 1.0f };
+    float attackInMilliseconds { 10.0f }, releaseInMilliseconds { 100.0f };
+    //detect on the sidechain bus instead of the band-passed main input
+    bool externalSidechain { false };
+
+    bool isActive() const noexcept { return ratio > 1.0f; }
+};
+
+//Level detector for the dynamic peak band. The detector input (main input or sidechain)
+//is mixed to mono; the main input is averaged over getDecimation samples and band-passed
+//around the peak frequency at that rate. Its peak over each update interval moves the
+//envelope, with separate attack and release, and the envelope is turned into the gain change
+//reached at the end of that interval: above the threshold the band is pulled down by
+//(level - threshold) * (1 - 1 / ratio) dB, at most maxGainChange. Between interval ends the
+//gain change is interpolated linearly, so even a fast attack moves the band over an interval.
+class DynamicPeak
+{
+public:
+    static constexpr float maxGainChange = 24.0f;
+    static constexpr int maxDecimation = 8;
+
+    //the band pass runs at sampleRate / getDecimation: at least 4 times its upper band edge
+    //and 16 times its centre
+    static int getDecimation(double sampleRate, float bandFrequency, float bandQuality) noexcept;
+
+    //message thread, sizes the gain change list for blocks up to maximumBlockSize
+    void prepare(double sampleRate, int maximumBlockSize);
+
+    //audio thread
+    void reset() noexcept;
+    //detectorBand is the band pass for the main input, designed at the host rate / decimation
+    void setParameters(const DynamicSettings& settings, const BiquadCoefficients& detectorBand, int decimation) noexcept;
+    const DynamicSettings& getSettings() const noexcept { return settings; }
+
+    //runs the detector over one block, one gain change per updateInterval samples;
+    //bandPass is off for the sidechain, which is followed as it is
+    template<typename SampleType>
+    void analyse(const SampleType* const* channels, int numChannels, int numSamples, int updateInterval, bool bandPass) noexcept;
+    //gain change in dB at sample (host rate) of the last analysed block; linear between the
+    //ends of its update intervals
+    float getGainChange(int sample) const noexcept;
+    int getUpdateInterval() const noexcept { return analysedInterval; }
+
+private:
+    DynamicSettings settings;
+    //direct form I, whose feedback is one multiply-add deep
+    struct BandState {
+        float x1 { 0 }, x2 { 0 }, y1 { 0 }, y2 { 0 };
+    };
+
+    BiquadCoefficients band;
+    BandState bandState;
+    int decimation { 1 };
+    //sum of the decimated sample still being collected, over decimatedCount samples
+    float decimatedSum { 0 };
+    int decimatedCount { 0 };
+    float envelope { 0 };
+    //per sample, and raised to the interval length
+    float attack { 0 }, release { 0 };
+    float intervalAttack { 0 }, intervalRelease { 0 };
+    double sampleRate { 44100.0 };
+
+    //per interval of the last block, reached at its end; startGainChange is where the block began
+    std::vector<float> gainChanges;
+    float startGainChange { 0 };
+    int numGainChanges { 0 }, numAnalysedSamples { 0 }, analysedInterval { 1 };
+};
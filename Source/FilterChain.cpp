@@ -0,0 +1,254 @@
+#include "FilterChain.h"
+#include "CoefficientTable.h"
+
+bool isLowCutNeutral(const ChainSettings& chainSettings) noexcept {
+    return chainSettings.lowCutFreq <= minCutFrequency;
+}
+
+bool isHighCutNeutral(const ChainSettings& chainSettings) noexcept {
+    return chainSettings.highCutFreq >= maxCutFrequency;
+}
+
+float getDefaultBandFrequency(int band) noexcept {
+    return minCutFrequency * std::pow(maxCutFrequency / minCutFrequency, (band + 0.5f) / (float) maxBands);
+}
+
+bool operator==(const BandSettings& a, const BandSettings& b) noexcept {
+    return a.type == b.type && a.freq == b.freq && a.gainInDecibels == b.gainInDecibels && a.quality == b.quality;
+}
+
+bool operator==(const ChainSettings& a, const ChainSettings& b) noexcept {
+    return a.peakGainInDecibels == b.peakGainInDecibels && a.peakFreq == b.peakFreq && a.peakQuality == b.peakQuality
+        && a.lowCutFreq == b.lowCutFreq && a.highCutFreq == b.highCutFreq
+        && a.lowCutSlope == b.lowCutSlope && a.highCutSlope == b.highCutSlope
+        && a.bands == b.bands && a.designMode == b.designMode;
+}
+
+double CutCoefficients::getMagnitudeForFrequency(double frequency, double sampleRate) const noexcept {
+
+    double mag = 1.0;
+
+    for(int i = 0; i < numStages; i++)
+        mag *= stages[i].getMagnitudeForFrequency(frequency, sampleRate);
+
+    return mag;
+}
+
+double BandCoefficients::getMagnitudeForFrequency(double frequency, double sampleRate) const noexcept {
+
+    double mag = 1.0;
+
+    for(int i = 0; i < numBands; i++)
+        mag *= stages[i].getMagnitudeForFrequency(frequency, sampleRate);
+
+    return mag;
+}
+
+double ChainCoefficients::getMagnitudeForFrequency(double frequency, double sampleRate) const noexcept {
+
+    return lowCut.getMagnitudeForFrequency(frequency, sampleRate)
+         * peak.getMagnitudeForFrequency(frequency, sampleRate)
+         * bands.getMagnitudeForFrequency(frequency, sampleRate)
+         * highCut.getMagnitudeForFrequency(frequency, sampleRate);
+}
+
+static BiquadDesign::Trig getTrig(const CoefficientTable* table, double sampleRate, double frequency) noexcept {
+    return table != nullptr ? table->getTrig(sampleRate, frequency) : BiquadDesign::getTrig(sampleRate, frequency);
+}
+
+static double getTanHalfOmega(const CoefficientTable* table, double sampleRate, double frequency) noexcept {
+    return table != nullptr ? table->getTanHalfOmega(sampleRate, frequency) : BiquadDesign::getTanHalfOmega(sampleRate, frequency);
+}
+
+static double getGainFactor(const CoefficientTable* table, double gainInDecibels) noexcept {
+    return table != nullptr ? table->getGainFactor(gainInDecibels) : std::pow(10.0, gainInDecibels * 0.05);
+}
+
+void makePeakFilter(BiquadCoefficients& peak, const ChainSettings& chainSettings, double sampleRate, const CoefficientTable* table) noexcept {
+
+    if(chainSettings.designMode == DesignMode_Matched) {
+        BiquadDesign::makeMatchedPeak(peak,
+                                      BiquadDesign::getMatchedOmega(sampleRate, chainSettings.peakFreq),
+                                      chainSettings.peakQuality,
+                                      std::pow(10.0, chainSettings.peakGainInDecibels * 0.05));
+        return;
+    }
+
+    BiquadDesign::makePeak(peak,
+                           getTrig(table, sampleRate, chainSettings.peakFreq),
+                           chainSettings.peakQuality,
+                           getGainFactor(table, chainSettings.peakGainInDecibels));
+}
+
+//Q of every section of every cut order, so a redesign needs no cosines for them
+static const auto butterworthQs = [] {
+    std::array<std::array<double, maxCutStages>, maxCutStages> qs {};
+
+    for(int slope = 0; slope < maxCutStages; slope++)
+        for(int i = 0; i <= slope; i++)
+            qs[(size_t) slope][(size_t) i] = BiquadDesign::butterworthQ(i, (slope + 1) * 2);
+
+    return qs;
+}();
+
+//the sections of a cut share one cutoff, so its tangent is taken once
+void makeLowCutFilter(CutCoefficients& lowCut, const ChainSettings& chainSettings, double sampleRate, const CoefficientTable* table) noexcept {
+
+    lowCut.numStages = isLowCutNeutral(chainSettings) ? 0 : chainSettings.lowCutSlope + 1;
+
+    if(lowCut.numStages == 0)
+        return;
+
+    if(chainSettings.designMode == DesignMode_Matched) {
+        const auto omega = BiquadDesign::getMatchedOmega(sampleRate, chainSettings.lowCutFreq);
+
+        for(int i = 0; i < lowCut.numStages; i++)
+            BiquadDesign::makeMatchedHighPass(lowCut.stages[i], omega, butterworthQs[(size_t) chainSettings.lowCutSlope][(size_t) i]);
+
+        return;
+    }
+
+    const auto tanHalfOmega = getTanHalfOmega(table, sampleRate, chainSettings.lowCutFreq);
+
+    for(int i = 0; i < lowCut.numStages; i++)
+        BiquadDesign::makeHighPassFromTan(lowCut.stages[i], tanHalfOmega, butterworthQs[(size_t) chainSettings.lowCutSlope][(size_t) i]);
+}
+
+void makeHighCutFilter(CutCoefficients& highCut, const ChainSettings& chainSettings, double sampleRate, const CoefficientTable* table) noexcept {
+
+    highCut.numStages = isHighCutNeutral(chainSettings) ? 0 : chainSettings.highCutSlope + 1;
+
+    if(highCut.numStages == 0)
+        return;
+
+    if(chainSettings.designMode == DesignMode_Matched) {
+        const auto omega = BiquadDesign::getMatchedOmega(sampleRate, chainSettings.highCutFreq);
+
+        for(int i = 0; i < highCut.numStages; i++)
+            BiquadDesign::makeMatchedLowPass(highCut.stages[i], omega, butterworthQs[(size_t) chainSettings.highCutSlope][(size_t) i]);
+
+        return;
+    }
+
+    const auto tanHalfOmega = getTanHalfOmega(table, sampleRate, chainSettings.highCutFreq);
+
+    for(int i = 0; i < highCut.numStages; i++)
+        BiquadDesign::makeLowPassFromTan(highCut.stages[i], tanHalfOmega, butterworthQs[(size_t) chainSettings.highCutSlope][(size_t) i]);
+}
+
+void makeBandFilter(BiquadCoefficients& band, const BandSettings& bandSettings, double sampleRate, const CoefficientTable* table) noexcept {
+
+    if(bandSettings.type == BandType_Off) {
+        band = {};
+        return;
+    }
+
+    const auto trig = getTrig(table, sampleRate, bandSettings.freq);
+
+    switch(bandSettings.type) {
+        case BandType_Peak:
+            BiquadDesign::makePeak(band, trig, bandSettings.quality, getGainFactor(table, bandSettings.gainInDecibels));
+            break;
+        case BandType_LowShelf:
+            BiquadDesign::makeLowShelf(band, trig, bandSettings.quality, getGainFactor(table, bandSettings.gainInDecibels));
+            break;
+        case BandType_HighShelf:
+            BiquadDesign::makeHighShelf(band, trig, bandSettings.quality, getGainFactor(table, bandSettings.gainInDecibels));
+            break;
+        case BandType_Notch:
+            BiquadDesign::makeNotch(band, trig, bandSettings.quality);
+            break;
+        case BandType_BandPass:
+            BiquadDesign::makeBandPass(band, trig, bandSettings.quality);
+            break;
+        case BandType_Off:
+        default:
+            band = {};
+            break;
+    }
+}
+
+void makeBandFilters(BandCoefficients& bands, const ChainSettings& chainSettings, double sampleRate, const CoefficientTable* table) noexcept {
+
+    bands.numBands = 0;
+
+    for(int i = 0; i < maxBands; i++) {
+        const auto& bandSettings = chainSettings.bands[(size_t) i];
+
+        if(bandSettings.type == BandType_Off)
+            continue;
+
+        auto& stage = bands.stages[(size_t) bands.numBands];
+        makeBandFilter(stage, bandSettings, sampleRate, table);
+
+        //a peak or shelf at 0 dB is not packed at all
+        if(!stage.isNeutral())
+            bands.bandIndices[(size_t) bands.numBands++] = i;
+    }
+}
+
+void makeChainCoefficients(ChainCoefficients& chainCoefficients, const ChainSettings& chainSettings, double sampleRate, const CoefficientTable* table) noexcept {
+
+    makeLowCutFilter(chainCoefficients.lowCut, chainSettings, sampleRate, table);
+    makePeakFilter(chainCoefficients.peak, chainSettings, sampleRate, table);
+    makeBandFilters(chainCoefficients.bands, chainSettings, sampleRate, table);
+    makeHighCutFilter(chainCoefficients.highCut, chainSettings, sampleRate, table);
+}
+
+//RBJ analog prototypes, (n2 s^2 + n1 s + n0) / (d2 s^2 + d1 s + d0) at s = j f / f0
+static double getBandPrototypeMagnitude(const BandSettings& band, double frequency) noexcept {
+
+    const double A = std::pow(10.0, band.gainInDecibels / 40.0);
+    const double q = band.quality;
+    const double sqrtAOverQ = std::sqrt(A) / q;
+
+    double n2 = 1.0, n1 = 0.0, n0 = 1.0, d2 = 1.0, d1 = 1.0 / q, d0 = 1.0;
+
+    switch(band.type) {
+        case BandType_Peak:      n1 = A / q; d1 = 1.0 / (A * q); break;
+        case BandType_LowShelf:  n2 = A; n1 = A * sqrtAOverQ; n0 = A * A; d2 = A; d1 = sqrtAOverQ; break;
+        case BandType_HighShelf: n2 = A * A; n1 = A * sqrtAOverQ; n0 = A; d1 = sqrtAOverQ; d0 = A; break;
+        case BandType_Notch:     break;
+        case BandType_BandPass:  n2 = 0.0; n1 = 1.0 / q; n0 = 0.0; break;
+        case BandType_Off:
+        default:                 return 1.0;
+    }
+
+    const auto w = frequency / band.freq;
+    const auto numerator = std::hypot(n0 - n2 * w * w, n1 * w);
+    const auto denominator = std::hypot(d0 - d2 * w * w, d1 * w);
+
+    return numerator / denominator;
+}
+
+double getPrototypeMagnitude(const ChainSettings& chainSettings, double frequency) noexcept {
+
+    //Butterworth of order n: |H|^2 = 1 / (1 + (f / fc)^2n), the high pass mirrored around fc
+    auto butterworth = [](double ratio, Slope slope) {
+        const auto order = (slope + 1) * 2;
+        return 1.0 / std::sqrt(1.0 + std::pow(ratio, 2.0 * order));
+    };
+
+    //RBJ peak prototype H(s) = (s^2 + s A / Q + 1) / (s^2 + s / (A Q) + 1), s = j f / f0
+    const double A = std::pow(10.0, chainSettings.peakGainInDecibels / 40.0);
+    const double q = chainSettings.peakQuality;
+    const auto w = frequency / chainSettings.peakFreq;
+    const auto real = (1.0 - w * w) * (1.0 - w * w);
+    const auto peak = std::sqrt((real + (w * A / q) * (w * A / q)) / (real + (w / (A * q)) * (w / (A * q))));
+
+    //neutral cuts are left out, as in the IIR chain
+    auto lowCut = 1.0, highCut = 1.0;
+
+    if(!isLowCutNeutral(chainSettings))
+        lowCut = frequency > 0.0 ? butterworth(chainSettings.lowCutFreq / frequency, chainSettings.lowCutSlope) : 0.0;
+
+    if(!isHighCutNeutral(chainSettings))
+        highCut = butterworth(frequency / chainSettings.highCutFreq, chainSettings.highCutSlope);
+
+    auto bands = 1.0;
+
+    for(const auto& band : chainSettings.bands)
+        bands *= getBandPrototypeMagnitude(band, frequency);
+
+    return lowCut * peak * bands * highCut;
+}
@@ -0,0 +1,215 @@
+#pragma once
+#include <array>
+#include "Biquad.h"
+
+class CoefficientTable;
+
+enum ChainPositions {
+    LowCut,
+    Peak,
+    HighCut
+};
+
+enum Slope {
+    Slope_12,
+    Slope_24,
+    Slope_36,
+    Slope_48
+};
+
+enum BandType {
+    BandType_Off,
+    BandType_Peak,
+    BandType_LowShelf,
+    BandType_HighShelf,
+    BandType_Notch,
+    BandType_BandPass
+};
+
+//how the peak and the cuts are designed: RBJ/Butterworth through the bilinear transform, or
+//matched to the analog magnitude, which keeps its shape up to Nyquist without oversampling
+enum DesignMode {
+    DesignMode_Bilinear,
+    DesignMode_Matched
+};
+
+constexpr int numDesignModes = 2;
+
+//parametric bands after the peak; each one is a single biquad, switched off ones cost nothing
+constexpr int maxBands = 24;
+
+//seconds a stage of the vector chains takes to fade in or out
+constexpr double stageFadeTime = 0.01;
+
+struct BandSettings {
+    BandType type { BandType_Off };
+    float freq { 1000.0f }, gainInDecibels { 0 }, quality { 1.0f };
+};
+
+struct ChainSettings {
+    float peakGainInDecibels {0}, peakFreq {0}, peakQuality {1.0f};
+    float lowCutFreq {0}, highCutFreq {0};
+    Slope lowCutSlope { Slope::Slope_12 }, highCutSlope { Slope::Slope_12 };
+    std::array<BandSettings, maxBands> bands;
+    //per instance, the same in both channel sets
+    DesignMode designMode { DesignMode_Bilinear };
+};
+
+bool operator==(const BandSettings& a, const BandSettings& b) noexcept;
+bool operator==(const ChainSettings& a, const ChainSettings& b) noexcept;
+
+//how a stereo bus is filtered: both channels with the first settings, each channel with
+//its own, or mid and side with their own
+enum ChannelMode {
+    ChannelMode_Linked,
+    ChannelMode_LeftRight,
+    ChannelMode_MidSide
+};
+
+//left or mid, right or side
+constexpr int numChannelSets = 2;
+
+//bands start spread evenly over 20 Hz - 20 kHz on a log scale
+float getDefaultBandFrequency(int band) noexcept;
+
+constexpr int maxCutStages = 4;
+
+//ends of the cut frequency ranges: a cut parked there is treated as switched off
+constexpr float minCutFrequency = 20.0f, maxCutFrequency = 20000.0f;
+
+bool isLowCutNeutral(const ChainSettings& chainSettings) noexcept;
+bool isHighCutNeutral(const ChainSettings& chainSettings) noexcept;
+
+//Butterworth cascade, one biquad per 12 dB/Oct, no stages when the cut is neutral
+struct CutCoefficients {
+    std::array<BiquadCoefficients, maxCutStages> stages;
+    int numStages { 1 };
+
+    double getMagnitudeForFrequency(double frequency, double sampleRate) const noexcept;
+};
+
+//the bands that are on and not neutral, packed in band order
+struct BandCoefficients {
+    std::array<BiquadCoefficients, maxBands> stages;
+    //band number of each packed stage
+    std::array<int, maxBands> bandIndices {};
+    int numBands { 0 };
+
+    double getMagnitudeForFrequency(double frequency, double sampleRate) const noexcept;
+};
+
+//everything one MonoChain needs, plain data so it can be copied on the audio thread
+struct ChainCoefficients {
+    CutCoefficients lowCut;
+    BiquadCoefficients peak;
+    BandCoefficients bands;
+    CutCoefficients highCut;
+
+    double getMagnitudeForFrequency(double frequency, double sampleRate) const noexcept;
+};
+
+//with a table the trigonometric and gain terms are looked up instead of calculated;
+//the matched designs need exponentials the table does not hold and always calculate
+void makePeakFilter(BiquadCoefficients& peak, const ChainSettings& chainSettings, double sampleRate, const CoefficientTable* table = nullptr) noexcept;
+void makeLowCutFilter(CutCoefficients& lowCut, const ChainSettings& chainSettings, double sampleRate, const CoefficientTable* table = nullptr) noexcept;
+void makeHighCutFilter(CutCoefficients& highCut, const ChainSettings& chainSettings, double sampleRate, const CoefficientTable* table = nullptr) noexcept;
+void makeBandFilter(BiquadCoefficients& band, const BandSettings& bandSettings, double sampleRate, const CoefficientTable* table = nullptr) noexcept;
+void makeBandFilters(BandCoefficients& bands, const ChainSettings& chainSettings, double sampleRate, const CoefficientTable* table = nullptr) noexcept;
+void makeChainCoefficients(ChainCoefficients& chainCoefficients, const ChainSettings& chainSettings, double sampleRate, const CoefficientTable* table = nullptr) noexcept;
+
+//magnitude of the analog prototypes the designers start from, free of bilinear cramping
+double getPrototypeMagnitude(const ChainSettings& chainSettings, double frequency) noexcept;
+
+//LowCut -> Peak -> Bands -> HighCut for one channel, coefficients and state held in fixed arrays.
+//Scalar reference for the vector chains, in any floating point sample type.
+template<typename SampleType>
+class MonoChain
+{
+public:
+    void reset() noexcept
+    {
+        for(auto& state : lowCutState)
+            state.reset();
+
+        for(auto& state : highCutState)
+            state.reset();
+
+        for(auto& state : bandState)
+            state.reset();
+
+        peakState.reset();
+    }
+
+    void setCoefficients(const ChainCoefficients& newCoefficients) noexcept
+    {
+        //stages switched on by a slope change start from silence instead of stale state
+        for(int i = coefficients.lowCut.numStages; i < newCoefficients.lowCut.numStages; i++)
+            lowCutState[i].reset();
+
+        for(int i = coefficients.highCut.numStages; i < newCoefficients.highCut.numStages; i++)
+            highCutState[i].reset();
+
+        //likewise bands that were off
+        std::array<bool, maxBands> wasOn {};
+
+        for(int k = 0; k < coefficients.bands.numBands; k++)
+            wasOn[(size_t) coefficients.bands.bandIndices[k]] = true;
+
+        for(int k = 0; k < newCoefficients.bands.numBands; k++)
+            if(!wasOn[(size_t) newCoefficients.bands.bandIndices[k]])
+                bandState[(size_t) newCoefficients.bands.bandIndices[k]].reset();
+
+        coefficients = newCoefficients;
+    }
+
+    const ChainCoefficients& getCoefficients() const noexcept { return coefficients; }
+
+    void process(SampleType* samples, int numSamples) noexcept
+    {
+        processCut(coefficients.lowCut, lowCutState, samples, numSamples);
+
+        const auto peak = coefficients.peak;
+        auto s = peakState;
+
+        for(int i = 0; i < numSamples; i++)
+            samples[i] = processSample(peak, s, samples[i]);
+
+        peakState = s;
+
+        for(int k = 0; k < coefficients.bands.numBands; k++) {
+            const auto c = coefficients.bands.stages[k];
+            auto& state = bandState[(size_t) coefficients.bands.bandIndices[k]];
+            auto bs = state;
+
+            for(int i = 0; i < numSamples; i++)
+                samples[i] = processSample(c, bs, samples[i]);
+
+            state = bs;
+        }
+
+        processCut(coefficients.highCut, highCutState, samples, numSamples);
+    }
+
+private:
+    using CutState = std::array<BiquadState<SampleType>, maxCutStages>;
+
+    static void processCut(const CutCoefficients& cut, CutState& state, SampleType* samples, int numSamples) noexcept
+    {
+        for(int stage = 0; stage < cut.numStages; stage++) {
+            const auto c = cut.stages[stage];
+            auto s = state[stage];
+
+            for(int i = 0; i < numSamples; i++)
+                samples[i] = processSample(c, s, samples[i]);
+
+            state[stage] = s;
+        }
+    }
+
+    ChainCoefficients coefficients;
+
+    CutState lowCutState, highCutState;
+    BiquadState<SampleType> peakState;
+    //by band number
+    std::array<BiquadState<SampleType>, maxBands> bandState;
+};
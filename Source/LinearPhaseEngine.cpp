@@ -0,0 +1,208 @@
+#include "LinearPhaseEngine.h"
+
+LinearPhaseEngine::LinearPhaseEngine()
+{
+    prepare(2);
+}
+
+void LinearPhaseEngine::prepare(int numChannels) {
+
+    channelStates.resize((size_t) juce::jmax(0, numChannels));
+
+    for(auto& state : channelStates) {
+        state.input.assign(fftSize, 0.0f);
+        state.delayLine.assign((size_t) maxPartitions * numBins * 2, 0.0f);
+        state.output.assign(partitionSize, 0.0f);
+    }
+
+    //the FFTs work in place on 2 * size floats
+    fftBuffer.assign(fftSize * 2, 0.0f);
+    crossfadeBuffer.assign(partitionSize, 0.0f);
+
+    reset();
+}
+
+void LinearPhaseEngine::reset() noexcept {
+
+    //the delay line (a quarter megabyte per channel) is not cleared: convolve reads only
+    //the entries written since, so a mode switch on the audio thread stays cheap
+    for(auto& state : channelStates) {
+        std::fill(state.input.begin(), state.input.end(), 0.0f);
+        std::fill(state.output.begin(), state.output.end(), 0.0f);
+    }
+
+    bufferedSamples = 0;
+    delayLinePosition = 0;
+    validPartitions = 0;
+
+    //the next kernel is taken without a crossfade
+    currentKernel.numPartitions = 0;
+    currentKernel.length = 0;
+    crossfadePosition = crossfadeLength;
+    currentDelay = previousDelay = 0;
+}
+
+void LinearPhaseEngine::designKernel(const ChainSettings& chainSettings, double sampleRate, int kernelLength) {
+
+    const auto length = juce::jlimit(minKernelLength, maxKernelLength, juce::nextPowerOfTwo(kernelLength));
+
+    if(designFFT == nullptr || designFFT->getSize() != length) {
+        int order = 0;
+        while((1 << order) < length)
+            order++;
+
+        designFFT = std::make_unique<juce::dsp::FFT>(order);
+    }
+
+    //zero-phase spectrum: the prototype magnitude on every bin, imaginary parts zero
+    designBuffer.assign((size_t) length * 2, 0.0f);
+
+    for(int bin = 0; bin <= length / 2; bin++)
+        designBuffer[(size_t) bin * 2] = (float) getPrototypeMagnitude(chainSettings, bin * sampleRate / length);
+
+    designFFT->performRealOnlyInverseTransform(designBuffer.data());
+
+    //symmetric window centred on length / 2, where the impulse is moved to make it causal
+    designWindow.resize((size_t) length + 1);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(designWindow.data(), (size_t) length + 1,
+                                                             juce::dsp::WindowingFunction<float>::blackman, false);
+
+    auto& kernel = kernels.getWriteBuffer();
+    kernel.length = length;
+    kernel.numPartitions = length / partitionSize;
+    kernel.partitions.resize((size_t) kernel.numPartitions * numBins * 2);
+
+    designFrame.resize(fftSize * 2);
+
+    for(int p = 0; p < kernel.numPartitions; p++) {
+        std::fill(designFrame.begin(), designFrame.end(), 0.0f);
+
+        for(int i = 0; i < partitionSize; i++) {
+            const auto n = p * partitionSize + i;
+            designFrame[(size_t) i] = designBuffer[(size_t) ((n + length / 2) % length)] * designWindow[(size_t) n];
+        }
+
+        partitionFFT.performRealOnlyForwardTransform(designFrame.data(), true);
+        std::copy_n(designFrame.data(), numBins * 2, kernel.partitions.data() + (size_t) p * numBins * 2);
+    }
+
+    kernels.publish();
+}
+
+void LinearPhaseEngine::update() noexcept {
+
+    //a kernel arriving mid-crossfade waits in the TripleBuffer until the fade is done
+    if(crossfadePosition < crossfadeLength || !kernels.pull())
+        return;
+
+    //moves the vectors only, nothing is allocated or freed here
+    std::swap(previousKernel, currentKernel);
+    std::swap(currentKernel, kernels.getReadBuffer());
+
+    crossfadePosition = previousKernel.numPartitions > 0 ? 0 : crossfadeLength;
+
+    //the lengths are powers of two from minKernelLength, so half their difference is whole partitions
+    const auto difference = crossfadePosition < crossfadeLength ? (currentKernel.length - previousKernel.length) / 2 / partitionSize : 0;
+    currentDelay = juce::jmax(0, -difference);
+    previousDelay = juce::jmax(0, difference);
+}
+
+int LinearPhaseEngine::getLatencySamples() const noexcept {
+    return currentKernel.length > 0 ? currentKernel.length / 2 + partitionSize + currentDelay * partitionSize : 0;
+}
+
+template<typename SampleType>
+void LinearPhaseEngine::process(SampleType* const* channels, int numChannels, int numSamples) noexcept {
+
+    update();
+
+    numChannels = juce::jmin(numChannels, (int) channelStates.size());
+    int done = 0;
+
+    while(done < numSamples) {
+        const auto length = juce::jmin(partitionSize - bufferedSamples, numSamples - done);
+
+        //input goes into the second half of the frame, output comes from the previous block
+        for(int ch = 0; ch < numChannels; ch++) {
+            auto& state = channelStates[(size_t) ch];
+            auto* samples = channels[ch] + done;
+
+            std::copy_n(samples, length, state.input.data() + partitionSize + bufferedSamples);
+            std::copy_n(state.output.data() + bufferedSamples, length, samples);
+        }
+
+        bufferedSamples += length;
+        done += length;
+
+        if(bufferedSamples == partitionSize) {
+            processPartition(numChannels);
+            bufferedSamples = 0;
+        }
+    }
+}
+
+template void LinearPhaseEngine::process<float>(float* const*, int, int) noexcept;
+template void LinearPhaseEngine::process<double>(double* const*, int, int) noexcept;
+
+void LinearPhaseEngine::processPartition(int numChannels) noexcept {
+
+    delayLinePosition = (delayLinePosition + 1) % maxPartitions;
+    validPartitions = juce::jmin(maxPartitions, validPartitions + 1);
+    const auto fading = crossfadePosition < crossfadeLength;
+
+    for(int ch = 0; ch < numChannels; ch++) {
+        auto& state = channelStates[(size_t) ch];
+
+        std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+        std::copy(state.input.begin(), state.input.end(), fftBuffer.begin());
+        fft.performRealOnlyForwardTransform(fftBuffer.data(), true);
+        std::copy_n(fftBuffer.data(), numBins * 2, state.delayLine.data() + (size_t) delayLinePosition * numBins * 2);
+
+        //overlap-save: the second half of the frame is the valid output
+        convolve(currentKernel, state, currentDelay);
+        const auto* convolved = fftBuffer.data() + partitionSize;
+
+        if(fading) {
+            std::copy_n(convolved, partitionSize, crossfadeBuffer.data());
+            convolve(previousKernel, state, previousDelay);
+
+            for(int i = 0; i < partitionSize; i++) {
+                const auto gain = (float) (crossfadePosition + i) / (float) crossfadeLength;
+                state.output[(size_t) i] = convolved[i] + gain * (crossfadeBuffer[(size_t) i] - convolved[i]);
+            }
+        }
+        else {
+            std::copy_n(convolved, partitionSize, state.output.data());
+        }
+
+        std::copy(state.input.begin() + partitionSize, state.input.end(), state.input.begin());
+    }
+
+    if(fading) {
+        crossfadePosition = juce::jmin(crossfadeLength, crossfadePosition + partitionSize);
+
+        if(crossfadePosition == crossfadeLength)
+            currentDelay = previousDelay = 0;
+    }
+}
+
+void LinearPhaseEngine::convolve(const Kernel& kernel, const ChannelState& state, int delay) noexcept {
+
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+    auto* accumulator = fftBuffer.data();
+    const auto numPartitions = juce::jmin(kernel.numPartitions, validPartitions - delay);
+
+    //partition p meets the input spectrum from p + delay blocks ago
+    for(int p = 0; p < numPartitions; p++) {
+        const auto slot = (delayLinePosition - p - delay + 2 * maxPartitions) % maxPartitions;
+        const auto* x = state.delayLine.data() + (size_t) slot * numBins * 2;
+        const auto* h = kernel.partitions.data() + (size_t) p * numBins * 2;
+
+        for(int bin = 0; bin < numBins * 2; bin += 2) {
+            accumulator[bin]     += x[bin] * h[bin]     - x[bin + 1] * h[bin + 1];
+            accumulator[bin + 1] += x[bin] * h[bin + 1] + x[bin + 1] * h[bin];
+        }
+    }
+
+    fft.performRealOnlyInverseTransform(fftBuffer.data());
+}
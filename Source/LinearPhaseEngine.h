@@ -0,0 +1,80 @@
+#pragma once
+#include <JuceHeader.h>
+#include "FilterChain.h"
+#include "TripleBuffer.h"
+
+//Linear-phase version of the whole chain: one FIR kernel run with partitioned overlap-save
+//convolution. Latency is kernelLength / 2 + partitionSize.
+class LinearPhaseEngine
+{
+public:
+    static constexpr int partitionSize = 256;
+    static constexpr int minKernelLength = 4096, maxKernelLength = 32768;
+    static constexpr int maxPartitions = maxKernelLength / partitionSize;
+    //samples the output blends from the old kernel to the new one
+    static constexpr int crossfadeLength = 8 * partitionSize;
+
+    LinearPhaseEngine();
+
+    //message thread, designer thread stopped
+    void prepare(int numChannels);
+
+    //designer thread: kernelLength is a power of two from minKernelLength to maxKernelLength
+    void designKernel(const ChainSettings& chainSettings, double sampleRate, int kernelLength);
+
+    //audio thread; clears only the partition in flight, the delay line is refilled before it is read
+    void reset() noexcept;
+    //takes a newly designed kernel, if there is one and no crossfade is running
+    void update() noexcept;
+    //float and double, the convolution itself always runs in float
+    template<typename SampleType>
+    void process(SampleType* const* channels, int numChannels, int numSamples) noexcept;
+    int getLatencySamples() const noexcept;
+
+private:
+    static constexpr int fftSize = 2 * partitionSize;
+    static constexpr int numBins = partitionSize + 1;
+
+    //spectra of the kernel partitions, numBins interleaved re/im pairs each
+    struct Kernel {
+        std::vector<float> partitions;
+        int numPartitions { 0 };
+        int length { 0 };
+    };
+
+    struct ChannelState {
+        //previous and current input block, the overlap-save FFT frame
+        std::vector<float> input;
+        //input spectra of the last maxPartitions blocks, a ring indexed by delayLinePosition
+        std::vector<float> delayLine;
+        //output of the last complete block, played back while the next one fills
+        std::vector<float> output;
+    };
+
+    void processPartition(int numChannels) noexcept;
+    //kernel applied to the input delayed by `delay` partitions
+    void convolve(const Kernel& kernel, const ChannelState& state, int delay) noexcept;
+
+    //fftSize points
+    juce::dsp::FFT fft { 9 };
+    std::vector<ChannelState> channelStates;
+    std::vector<float> fftBuffer, crossfadeBuffer;
+    int bufferedSamples { 0 };
+    int delayLinePosition { 0 };
+    //delay line entries written since the last reset, older ones are stale
+    int validPartitions { 0 };
+
+    Kernel currentKernel, previousKernel;
+    int crossfadePosition { crossfadeLength };
+    //partitions each kernel is delayed by while the crossfade runs
+    int currentDelay { 0 }, previousDelay { 0 };
+
+    TripleBuffer<Kernel> kernels;
+
+    //designer thread only
+    juce::dsp::FFT partitionFFT { 9 };
+    std::unique_ptr<juce::dsp::FFT> designFFT;
+    std::vector<float> designBuffer, designWindow, designFrame;
+
+    JUCE_DECLARE_NON_COPYABLE(LinearPhaseEngine)
+};
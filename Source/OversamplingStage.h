@@ -0,0 +1,206 @@
+#pragma once
+#include <JuceHeader.h>
+
+//the chain runs at (1 << order) times the host rate, order 0 = off
+struct OversamplingSettings {
+    int order { 0 };
+    //FIR equiripple half-bands (linear phase) instead of polyphase IIR (low latency)
+    bool linearPhase { false };
+};
+
+constexpr int maxOversamplingOrder = 3;
+
+//Every factor / half-band type of juce::dsp::Oversampling for one sample type.
+//All of them are built in prepare(), so select() on the audio thread only picks one
+//and clears its state. While the order is 0 nothing is processed. For a crossfade
+//between two factors select() can keep the previous one running as the outgoing one,
+//and the side with the lower latency is delayed to the other's.
+template<typename SampleType>
+class OversamplingStage
+{
+public:
+    //not real-time safe
+    void prepare(int numChannels, int maximumBlockSize)
+    {
+        blockSize = juce::jmax(1, maximumBlockSize);
+        channels.assign((size_t) numChannels, nullptr);
+        int maxLatency = 0;
+
+        for(int linearPhase = 0; linearPhase < 2; linearPhase++)
+            for(int order = 1; order <= maxOversamplingOrder; order++) {
+                const auto filterType = linearPhase ? Oversampler::filterHalfBandFIREquiripple
+                                                    : Oversampler::filterHalfBandPolyphaseIIR;
+
+                auto& oversampler = oversamplers[(size_t) linearPhase][(size_t) order - 1];
+                oversampler = std::make_unique<Oversampler>((size_t) numChannels, (size_t) order, filterType, true, true);
+                oversampler->initProcessing((size_t) blockSize);
+                maxLatency = juce::jmax(maxLatency, getLatency(oversampler.get()));
+            }
+
+        alignment.setSize(numChannels, juce::jmax(1, maxLatency));
+        alignment.clear();
+        alignmentPosition = alignmentDelay = 0;
+        alignedSide = AlignedSide::none;
+        active = outgoing = nullptr;
+    }
+
+    //frees the buffers, e.g. for the sample type the host is not using
+    void release()
+    {
+        for(auto& row : oversamplers)
+            for(auto& oversampler : row)
+                oversampler.reset();
+
+        alignment.setSize(0, 0);
+        alignedSide = AlignedSide::none;
+        active = outgoing = nullptr;
+    }
+
+    //with keepOutgoing the oversampler selected so far (none at order 0) stays in use for
+    //processOutgoing until endOutgoing; the settings must differ from the current ones
+    void select(const OversamplingSettings& settings, bool keepOutgoing = false) noexcept
+    {
+        const auto outgoingLatency = getLatency(active);
+        outgoing = keepOutgoing ? active : nullptr;
+        active = settings.order > 0 ? oversamplers[settings.linearPhase ? 1 : 0][(size_t) settings.order - 1].get() : nullptr;
+
+        if(active != nullptr)
+            active->reset();
+
+        //a delayed outgoing side goes on from the output kept so far, a delayed new one from silence
+        const auto difference = keepOutgoing ? getLatency(active) - outgoingLatency : 0;
+        alignedSide = difference > 0 ? AlignedSide::outgoing : (difference < 0 ? AlignedSide::active : AlignedSide::none);
+        alignmentDelay = std::abs(difference);
+
+        if(alignedSide == AlignedSide::active)
+            alignment.clear();
+    }
+
+    bool isActive() const noexcept { return active != nullptr; }
+    bool hasOutgoing() const noexcept { return outgoing != nullptr; }
+
+    //the new side drops to its own latency
+    void endOutgoing() noexcept
+    {
+        outgoing = nullptr;
+        alignedSide = AlignedSide::none;
+    }
+
+    //while the new side is delayed both are at the outgoing one's latency
+    int getLatencySamples() const noexcept
+    {
+        return getLatency(active) + (alignedSide == AlignedSide::active ? alignmentDelay : 0);
+    }
+
+    //during a crossfade, on the host rate output of either side: delays it if it is the one with
+    //the lower latency. Outside one, keepOutput holds on to the last output for the next crossfade
+    void alignOutgoing(SampleType* const* samples, int numChannels, int numSamples) noexcept
+    {
+        if(alignedSide == AlignedSide::outgoing)
+            delay(samples, numChannels, numSamples);
+    }
+
+    void alignActive(SampleType* const* samples, int numChannels, int numSamples) noexcept
+    {
+        if(alignedSide == AlignedSide::active)
+            delay(samples, numChannels, numSamples);
+    }
+
+    void keepOutput(const SampleType* const* samples, int numChannels, int numSamples) noexcept
+    {
+        const auto size = alignment.getNumSamples();
+        const auto first = juce::jmax(0, numSamples - size);
+
+        for(int ch = 0; ch < juce::jmin(numChannels, alignment.getNumChannels()); ch++) {
+            auto* ring = alignment.getWritePointer(ch);
+
+            for(int i = first; i < numSamples; i++)
+                ring[(alignmentPosition + i) % size] = samples[ch][i];
+        }
+
+        if(size > 0)
+            alignmentPosition = (alignmentPosition + numSamples) % size;
+    }
+
+    //upsamples, calls processOversampled(channels, numChannels, numSamples) at the higher rate, downsamples
+    template<typename ProcessOversampled>
+    void process(juce::AudioBuffer<SampleType>& buffer, int numChannels, ProcessOversampled&& processOversampled) noexcept
+    {
+        if(numChannels > 0)
+            processWith(active, juce::dsp::AudioBlock<SampleType>(buffer).getSubsetChannelBlock(0, (size_t) numChannels), processOversampled);
+    }
+
+    //the same through the outgoing oversampler
+    template<typename ProcessOversampled>
+    void processOutgoing(SampleType* const* samples, int numChannels, int numSamples, ProcessOversampled&& processOversampled) noexcept
+    {
+        if(numChannels > 0)
+            processWith(outgoing, juce::dsp::AudioBlock<SampleType>(samples, (size_t) numChannels, (size_t) numSamples), processOversampled);
+    }
+
+private:
+    using Oversampler = juce::dsp::Oversampling<SampleType>;
+
+    enum class AlignedSide { none, outgoing, active };
+
+    //integer latencies, see the constructor in prepare
+    static int getLatency(const Oversampler* oversampler) noexcept
+    {
+        return oversampler != nullptr ? juce::roundToInt(oversampler->getLatencyInSamples()) : 0;
+    }
+
+    //alignmentDelay samples through the ring, which holds the last samples written to it
+    void delay(SampleType* const* samples, int numChannels, int numSamples) noexcept
+    {
+        const auto size = alignment.getNumSamples();
+
+        for(int ch = 0; ch < juce::jmin(numChannels, alignment.getNumChannels()); ch++) {
+            auto* ring = alignment.getWritePointer(ch);
+            auto position = alignmentPosition;
+
+            for(int i = 0; i < numSamples; i++) {
+                const auto input = samples[ch][i];
+                samples[ch][i] = ring[(position - alignmentDelay + size) % size];
+                ring[position] = input;
+                position = (position + 1) % size;
+            }
+        }
+
+        if(size > 0)
+            alignmentPosition = (alignmentPosition + numSamples) % size;
+    }
+
+    template<typename ProcessOversampled>
+    void processWith(Oversampler* oversampler, juce::dsp::AudioBlock<SampleType> block, ProcessOversampled& processOversampled) noexcept
+    {
+        if(oversampler == nullptr)
+            return;
+
+        const auto numChannels = (int) block.getNumChannels();
+
+        //hosts may send more than samplesPerBlock, the oversampler buffers only hold that much
+        for(size_t start = 0; start < block.getNumSamples(); start += (size_t) blockSize) {
+            auto subBlock = block.getSubBlock(start, juce::jmin((size_t) blockSize, block.getNumSamples() - start));
+            auto oversampledBlock = oversampler->processSamplesUp(subBlock);
+
+            for(size_t ch = 0; ch < (size_t) numChannels; ch++)
+                channels[ch] = oversampledBlock.getChannelPointer(ch);
+
+            processOversampled(channels.data(), numChannels, (int) oversampledBlock.getNumSamples());
+            oversampler->processSamplesDown(subBlock);
+        }
+    }
+
+    //[linearPhase][order - 1]
+    std::array<std::array<std::unique_ptr<Oversampler>, maxOversamplingOrder>, 2> oversamplers;
+    Oversampler* active { nullptr };
+    Oversampler* outgoing { nullptr };
+
+    //as long as the largest latency of any factor, the longest delay a crossfade needs
+    juce::AudioBuffer<SampleType> alignment;
+    int alignmentPosition { 0 }, alignmentDelay { 0 };
+    AlignedSide alignedSide { AlignedSide::none };
+
+    std::vector<SampleType*> channels;
+    int blockSize { 0 };
+};
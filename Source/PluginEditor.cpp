@@ -10,49 +10,94 @@ void LookAndFeel::drawRotarySlider (juce::Graphics& g, int x, int y, int width,
     
     auto bounds = Rectangle<float>(x, y, width, height);
     
-    g.setColour(Colours::white);
-    g.fillEllipse(bounds);
-    
-    g.setColour(Colours::green);
-    g.drawEllipse(bounds, 2.0f);
+    drawRotaryBody(g, bounds);
     
     //jeżeli nasz slider jest rotary with labels
     if( auto* rswl = dynamic_cast<RotarySliderWithLabels*>(&slider))
     {
-        auto center = bounds.getCentre();
-        Path p;
-        
-        Rectangle<float> r;
-        r.setLeft(center.getX() - 3);
-        r.setRight(center.getX() + 3);
-        r.setTop(bounds.getY());
-        r.setBottom(center.getY() - rswl->getTextHeight() * 1.5);
-        
-        p.addRoundedRectangle(r, 2.0f);
-        
         jassert(rotaryEndAngle > rotaryStartAngle);
         auto sliderAngRad = jmap(sliderPosProportional, 0.0f, 1.0f, rotaryStartAngle, rotaryEndAngle);
         
-        p.applyTransform(AffineTransform().rotation(sliderAngRad, center.getX(), center.getY()));
-        
-        g.fillPath(p);
-        
-        g.setFont(rswl->getTextHeight());
-        
         auto text = rswl->getDisplayString();
-        auto strWidth = g.getCurrentFont().getStringWidth(text);
-        
-        r.setSize(strWidth + 4, rswl->getTextHeight() + 2);
-        r.setCentre(bounds.getCentre());
-        
-        g.setColour(Colours::black);
-        g.fillRect(r);
-        
-        g.setColour(Colours::white);
-        g.drawFittedText(text, r.toNearestInt(), Justification::centred, 1);
+        drawRotaryPointerAndLabel(g, bounds, sliderAngRad, rswl->getTextHeight(), text,
+                                  Font((float) rswl->getTextHeight()).getStringWidthFloat(text));
     }
 }
 
+void LookAndFeel::drawRotaryBody(juce::Graphics& g, juce::Rectangle<float> bounds)
+{
+    using namespace juce;
+    
+    g.setColour(Colours::white);
+    g.fillEllipse(bounds);
+    
+    g.setColour(Colours::green);
+    g.drawEllipse(bounds, 2.0f);
+}
+
+void LookAndFeel::drawRotaryPointerAndLabel(juce::Graphics& g, juce::Rectangle<float> bounds, float angle,
+                                            int textHeight, const juce::String& text, float textWidth)
+{
+    using namespace juce;
+    
+    auto center = bounds.getCentre();
+    Path p;
+    
+    Rectangle<float> r;
+    r.setLeft(center.getX() - 3);
+    r.setRight(center.getX() + 3);
+    r.setTop(bounds.getY());
+    r.setBottom(center.getY() - textHeight * 1.5);
+    
+    p.addRoundedRectangle(r, 2.0f);
+    p.applyTransform(AffineTransform().rotation(angle, center.getX(), center.getY()));
+    
+    g.setColour(Colours::green);
+    g.fillPath(p);
+    
+    g.setFont((float) textHeight);
+    
+    r.setSize(std::ceil(textWidth) + 4, textHeight + 2);
+    r.setCentre(center);
+    
+    g.setColour(Colours::black);
+    g.fillRect(r);
+    
+    g.setColour(Colours::white);
+    g.drawFittedText(text, r.toNearestInt(), Justification::centred, 1);
+}
+
+#if FILTERPLUGIN_PROFILING
+PaintTimer& PaintTimer::getInstance()
+{
+    static PaintTimer instance;
+    return instance;
+}
+
+void PaintTimer::add(double milliseconds) noexcept
+{
+    numPaints++;
+    totalMilliseconds += milliseconds;
+    worstMilliseconds = juce::jmax(worstMilliseconds, milliseconds);
+}
+
+PaintTimer::Snapshot PaintTimer::takeSnapshot() noexcept
+{
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+    
+    Snapshot snapshot;
+    snapshot.numPaints = numPaints;
+    snapshot.averageMicroseconds = numPaints > 0 ? totalMilliseconds * 1000.0 / numPaints : 0.0;
+    snapshot.worstMicroseconds = worstMilliseconds * 1000.0;
+    snapshot.busyFraction = now > intervalStart ? totalMilliseconds / (now - intervalStart) : 0.0;
+    
+    numPaints = 0;
+    totalMilliseconds = worstMilliseconds = 0;
+    intervalStart = now;
+    return snapshot;
+}
+#endif
+
 juce::String RotarySliderWithLabels::getDisplayString() const
 {
     //sprawdzamy czy param jest parametrem typu choice
@@ -93,22 +138,46 @@ void RotarySliderWithLabels::paint(juce::Graphics& g)
 {
     using namespace juce;
     
-    const auto startAngle = degreesToRadians(180.0 + 45.0);
-    const auto endAngle = degreesToRadians(180.0 - 45.0) + MathConstants<float>::twoPi;
+   #if FILTERPLUGIN_PROFILING
+    PaintTimer::Scope paintScope(PaintTimer::getInstance());
+   #endif
+    
+    const auto startAngle = degreesToRadians(180.0f + 45.0f);
+    const auto endAngle = degreesToRadians(180.0f - 45.0f) + MathConstants<float>::twoPi;
     
     auto range = getRange();
-    auto bounds = getSliderBounds();
+    auto bounds = getSliderBounds().toFloat();
     
-    getLookAndFeel().drawRotarySlider(g,
-                                      bounds.getX(),
-                                      bounds.getY(),
-                                      bounds.getWidth(),
-                                      bounds.getHeight(),
-                                      jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0),
-                                      startAngle,
-                                      endAngle,
-                                      *this);
+    //the border is stroked across the edge of the bounds, so the image has a margin for it
+    const auto bodyArea = bounds.expanded(2.0f);
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
     
+    if(bodyImage.isNull() || scale != bodyImageScale) {
+        bodyImageScale = scale;
+        bodyImage = Image(Image::ARGB, jmax(1, roundToInt(bodyArea.getWidth() * scale)), jmax(1, roundToInt(bodyArea.getHeight() * scale)), true);
+        
+        Graphics imageGraphics(bodyImage);
+        imageGraphics.addTransform(AffineTransform::scale(scale));
+        LookAndFeel::drawRotaryBody(imageGraphics, bounds.withPosition(2.0f, 2.0f));
+    }
+    
+    g.drawImage(bodyImage, bodyArea);
+    
+    if(getValue() != displayedValue) {
+        displayedValue = getValue();
+        displayString = getDisplayString();
+        displayStringWidth = Font((float) getTextHeight()).getStringWidthFloat(displayString);
+    }
+    
+    const auto proportion = (float) jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0);
+    LookAndFeel::drawRotaryPointerAndLabel(g, bounds, jmap(proportion, startAngle, endAngle),
+                                           getTextHeight(), displayString, displayStringWidth);
+}
+
+void RotarySliderWithLabels::resized()
+{
+    juce::Slider::resized();
+    bodyImage = {};
 }
 
 juce::Rectangle<int> RotarySliderWithLabels::getSliderBounds() const
@@ -131,6 +200,9 @@ ResponsiveCurveComponent::ResponsiveCurveComponent(FilterPluginAudioProcessor& p
     for(const auto& param : params) {
         param->addListener(this);
     }
+    audioProcessor.getAnalyser().setEnabled(true);
+    //the background image covers every pixel, nothing behind needs to be painted
+    setOpaque(true);
     startTimerHz(60);
 }
 
@@ -140,76 +212,125 @@ ResponsiveCurveComponent::~ResponsiveCurveComponent()
     for(const auto& param : params) {
         param->removeListener(this);
     }
+    audioProcessor.getAnalyser().setEnabled(false);
 }
 
 void ResponsiveCurveComponent::parameterValueChanged (int parameterIndex, float newValue) {
     parametersChanged.set(true);
 }
 
+void ResponsiveCurveComponent::setChannelSet(int set) {
+    channelSet = set;
+    parametersChanged.set(true);
+}
+
 void ResponsiveCurveComponent::timerCallback() {
     if(parametersChanged.compareAndSetBool(false, true)) {
         //aktualizacja monochain
-        auto chainSettings = getChainSettings(audioProcessor.apvts);
-        auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-        updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-        
-        auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-        auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
-        updateCutFilter(monoChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-        updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+        auto chainSettings = getChainSettings(audioProcessor.apvts, channelSet);
+        coefficientCache->makeChainCoefficients(chainCoefficients, chainSettings, audioProcessor.getFilterSampleRate());
         
-        repaint();
+        updateResponseCurve(false);
     }
+    
+    if(auto* spectrum = audioProcessor.getAnalyser().pullSpectrum())
+        repaint(updateSpectrumPaths(*spectrum));
 }
 
-void ResponsiveCurveComponent::paint(juce::Graphics &g)
-{
+juce::Rectangle<int> ResponsiveCurveComponent::updateSpectrumPaths(const SpectrumAnalyser::Spectrum& spectrum) {
     using namespace juce;
-    g.fillAll (Colours::black);
-    
-    auto responseArea = getLocalBounds();
-    
-    auto w = responseArea.getWidth();
     
-    auto& lowCut = monoChain.get<ChainPositions::LowCut>();
-    auto& peak = monoChain.get<ChainPositions::Peak>();
-    auto& highCut = monoChain.get<ChainPositions::HighCut>();
+    auto responseArea = getLocalBounds().toFloat();
+    Rectangle<float> dirty;
+    const auto xScale = responseArea.getWidth() / (float) SpectrumAnalyser::numPoints;
     
-    std::vector<float> mags;
-    mags.resize(w);
-    auto sampleRate = audioProcessor.getSampleRate();
+    auto map = [responseArea](float decibels) {
+        return jmap(jlimit(-84.0f, 0.0f, decibels), -84.0f, 0.0f, responseArea.getBottom(), responseArea.getY());
+    };
     
-    //w - szerokosc obszaru na którym będzie linia
-    for(int i = 0; i < w; i++) {
-        double mag = 1.0f;
-        //zamieniamy szerokosc obszaru w 1/100 na czestotliwosci
-        auto freq = mapToLog10((double)i / (double)w, 20.0, 20000.0);
+    for(size_t tap = 0; tap < spectrumPaths.size(); tap++) {
+        auto& path = spectrumPaths[tap];
+        const auto& decibels = spectrum.decibels[tap];
         
-        if(!monoChain.isBypassed<ChainPositions::Peak>())
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
+        dirty = dirty.getUnion(path.getBounds());
+        path.clear();
+        path.preallocateSpace(SpectrumAnalyser::numPoints * 3);
+        path.startNewSubPath(responseArea.getX(), map(decibels[0]));
         
-        if(!lowCut.isBypassed<0>())
-            mag *= lowCut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if(!lowCut.isBypassed<1>())
-            mag *= lowCut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if(!lowCut.isBypassed<2>())
-            mag *= lowCut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if(!lowCut.isBypassed<3>())
-            mag *= lowCut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
+        for(int i = 1; i < SpectrumAnalyser::numPoints; i++)
+            path.lineTo(responseArea.getX() + i * xScale, map(decibels[(size_t) i]));
         
-        if(!highCut.isBypassed<0>())
-            mag *= highCut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if(!highCut.isBypassed<1>())
-            mag *= highCut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if(!highCut.isBypassed<2>())
-            mag *= highCut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        if(!highCut.isBypassed<3>())
-            mag *= highCut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        
-        mags[i] = Decibels::gainToDecibels(mag);
+        dirty = dirty.getUnion(path.getBounds());
+    }
+    
+    return getStrokedArea(dirty, spectrumStrokeWidth);
+}
+
+juce::Rectangle<int> ResponsiveCurveComponent::getStrokedArea(juce::Rectangle<float> pathBounds, float strokeWidth) {
+    
+    //a mitered joint at a sharp peak reaches past the line by up to about three half widths,
+    //plus a pixel for antialiasing
+    return pathBounds.expanded(strokeWidth * 1.5f + 1.0f).getSmallestIntegerContainer();
+}
+
+void ResponsiveCurveComponent::resized() {
+    backgroundImage = {};
+    updateResponseCurve(true);
+    repaint();
+}
+
+void ResponsiveCurveComponent::renderBackground(float scale) {
+    using namespace juce;
+    
+    auto responseArea = getLocalBounds().toFloat();
+    backgroundImageScale = scale;
+    backgroundImage = Image(Image::RGB, jmax(1, roundToInt(responseArea.getWidth() * scale)), jmax(1, roundToInt(responseArea.getHeight() * scale)), true);
+    
+    Graphics g(backgroundImage);
+    g.addTransform(AffineTransform::scale(scale));
+    g.fillAll(Colours::black);
+    
+    //decades and their halves on the 20 Hz - 20 kHz axis of the curve, every 12 dB on its -24 - 24 dB axis
+    g.setColour(Colours::dimgrey.withAlpha(0.4f));
+    
+    for(auto freq : { 50.0f, 100.0f, 200.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f, 10000.0f }) {
+        const auto x = responseArea.getX() + responseArea.getWidth() * std::log(freq / 20.0f) / std::log(1000.0f);
+        g.drawVerticalLine(roundToInt(x), responseArea.getY(), responseArea.getBottom());
     }
     
-    Path responseCurve;
+    for(auto gain : { -12.0f, 0.0f, 12.0f }) {
+        const auto y = jmap(gain, -24.0f, 24.0f, responseArea.getBottom(), responseArea.getY());
+        g.drawHorizontalLine(roundToInt(y), responseArea.getX(), responseArea.getRight());
+    }
+    
+    g.setColour(Colours::green);
+    g.drawRoundedRectangle(responseArea, 4.0f, 1.0f);
+}
+
+void ResponsiveCurveComponent::updateResponseCurve(bool force) {
+    using namespace juce;
+    
+    auto responseArea = getLocalBounds();
+    auto sampleRate = audioProcessor.getFilterSampleRate();
+    
+    //not prepared yet
+    if(sampleRate <= 0.0)
+        return;
+    
+    if(force || sampleRate != curveSampleRate) {
+        curveSampleRate = sampleRate;
+        coefficientCache->makeChainCoefficients(chainCoefficients, getChainSettings(audioProcessor.apvts, channelSet), sampleRate);
+        //zamieniamy szerokosc obszaru na czestotliwosci 20 Hz - 20 kHz
+        responseCurve.setFrequencies(responseArea.getWidth(), 20.0, 20000.0, sampleRate);
+    }
+    
+    if(!responseCurve.update(chainCoefficients) || responseCurve.getNumPoints() == 0)
+        return;
+    
+    const auto* mags = responseCurve.getDecibels();
+    
+    //the old curve has to be painted over as well as the new one drawn
+    auto dirty = responseCurvePath.getBounds();
     
     const double outputMin = responseArea.getBottom();
     const double outputMax = responseArea.getY();
@@ -217,58 +338,257 @@ void ResponsiveCurveComponent::paint(juce::Graphics &g)
         return jmap(input, -24.0, 24.0, outputMin, outputMax);
     };
     
-    responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
+    responseCurvePath.clear();
+    responseCurvePath.preallocateSpace(responseCurve.getNumPoints() * 3);
+    responseCurvePath.startNewSubPath(responseArea.getX(), map(mags[0]));
     
-    for(size_t i = 0; i < mags.size(); i++) {
-        responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
+    for(int i = 1; i < responseCurve.getNumPoints(); i++) {
+        responseCurvePath.lineTo(responseArea.getX() + i, map(mags[i]));
     }
     
-    g.setColour(Colours::green);
-    g.drawRoundedRectangle(responseArea.toFloat(), 4.0f, 1.0f);
+    repaint(getStrokedArea(dirty.getUnion(responseCurvePath.getBounds()), curveStrokeWidth));
+}
+
+void ResponsiveCurveComponent::paint(juce::Graphics &g)
+{
+    using namespace juce;
+    
+   #if FILTERPLUGIN_PROFILING
+    PaintTimer::Scope paintScope(PaintTimer::getInstance());
+   #endif
+    
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    
+    if(backgroundImage.isNull() || scale != backgroundImageScale)
+        renderBackground(scale);
+    
+    g.drawImage(backgroundImage, getLocalBounds().toFloat());
+    
+    g.setColour(Colours::darkgrey);
+    g.strokePath(spectrumPaths[SpectrumAnalyser::PreFilter], PathStrokeType(spectrumStrokeWidth));
+    
+    g.setColour(Colours::darkgreen);
+    g.strokePath(spectrumPaths[SpectrumAnalyser::PostFilter], PathStrokeType(spectrumStrokeWidth));
     
     g.setColour(Colours::white);
-    g.strokePath(responseCurve, PathStrokeType(2.0f));
+    g.strokePath(responseCurvePath, PathStrokeType(curveStrokeWidth));
+}
+
+#if FILTERPLUGIN_PROFILING
+ProfilerOverlay::ProfilerOverlay(Profiler& p) : profiler(p)
+{
+    setInterceptsMouseClicks(false, false);
+    startTimerHz(4);
+}
+
+void ProfilerOverlay::timerCallback()
+{
+    snapshot = profiler.getSnapshot();
+    paintSnapshot = PaintTimer::getInstance().takeSnapshot();
+    repaint();
+}
+
+void ProfilerOverlay::paint(juce::Graphics& g)
+{
+    using namespace juce;
+    
+    auto area = getLocalBounds().reduced(6).removeFromLeft(220);
+    g.setColour(Colours::black.withAlpha(0.7f));
+    g.fillRect(area);
+    area.reduce(4, 2);
+    
+    g.setFont(Font(Font::getDefaultMonospacedFontName(), 11.0f, Font::plain));
+    const auto lineHeight = 13;
+    
+    auto drawLine = [&](const String& text, Colour colour) {
+        g.setColour(colour);
+        g.drawText(text, area.removeFromTop(lineHeight), Justification::centredLeft, false);
+    };
+    
+    //every editor in the process, this overlay excluded
+    drawLine("ui " + String(paintSnapshot.numPaints) + " paints, " + String(paintSnapshot.averageMicroseconds, 1) + " / "
+             + String(paintSnapshot.worstMicroseconds, 1) + " us, " + String(paintSnapshot.busyFraction * 100.0, 1) + "%", Colours::lightgrey);
+    
+    if(!snapshot.calibrated) {
+        drawLine("profiler: calibrating", Colours::white);
+        return;
+    }
+    
+    //over 75% of the budget is close enough to a dropout to stand out
+    drawLine("load " + String(snapshot.averageLoad * 100.0, 1) + "% avg, " + String(snapshot.worstLoad * 100.0, 1) + "% worst",
+             snapshot.worstLoad > 0.75 ? Colours::orange : Colours::white);
+    drawLine(String((int64) snapshot.numBlocks) + " blocks, " + String((int64) snapshot.numOverruns) + " over deadline",
+             snapshot.numOverruns > 0 ? Colours::red : Colours::white);
+    
+    for(int i = 0; i < numProfileSections; i++) {
+        const auto& section = snapshot.sections[(size_t) i];
+        
+        if(section.count > 0)
+            drawLine(String(Profiler::getSectionName(static_cast<ProfileSection>(i))).paddedRight(' ', 13)
+                     + String(section.averageMicroseconds, 1) + " / " + String(section.maxMicroseconds, 1) + " us", Colours::lightgrey);
+    }
+    
+    //load histogram, 0 - 200% and over, bar heights on a log scale
+    auto histogramArea = area.removeFromTop(30).reduced(0, 2).toFloat();
+    const auto binWidth = histogramArea.getWidth() / Profiler::numLoadBins;
+    const auto maxCount = (float) *std::max_element(snapshot.loadHistogram.begin(), snapshot.loadHistogram.end());
     
-    g.setColour (juce::Colours::white);
+    for(int i = 0; i < Profiler::numLoadBins && maxCount > 0; i++) {
+        const auto count = (float) snapshot.loadHistogram[(size_t) i];
+        const auto height = count > 0 ? histogramArea.getHeight() * std::log1p(count) / std::log1p(maxCount) : 0.0f;
+        
+        g.setColour(i < 20 ? Colours::lightgreen : Colours::red);
+        g.fillRect(histogramArea.getX() + i * binWidth, histogramArea.getBottom() - height, juce::jmax(1.0f, binWidth - 1.0f), height);
+    }
 }
+#endif
 
 FilterPluginAudioProcessorEditor::FilterPluginAudioProcessorEditor (FilterPluginAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p),
-    peakFreqSlider(*audioProcessor.apvts.getParameter("Peak Freq"), "Hz"),
-    peakGainSlider(*audioProcessor.apvts.getParameter("Peak Gain"), "dB"),
-    peakQualitySlider(*audioProcessor.apvts.getParameter("Peak Quality"), ""),
-    lowCutFreqSlider(*audioProcessor.apvts.getParameter("LowCut Freq"), "Hz"),
-    lowCutSlopeSlider(*audioProcessor.apvts.getParameter("LowCut Slope"), "db/Oct"),
-    highCutFreqSlider(*audioProcessor.apvts.getParameter("HighCut Freq"), "Hz"),
-    highCutSlopeSlider(*audioProcessor.apvts.getParameter("HighCut Slope"), "db/Oct"),
+    peakThresholdSlider(*audioProcessor.apvts.getParameter("Peak Threshold"), "dB"),
+    peakRatioSlider(*audioProcessor.apvts.getParameter("Peak Ratio"), ":1"),
+    peakAttackSlider(*audioProcessor.apvts.getParameter("Peak Attack"), "ms"),
+    peakReleaseSlider(*audioProcessor.apvts.getParameter("Peak Release"), "ms"),
+    peakDetectorComboBox(*audioProcessor.apvts.getParameter("Peak Detector")),
+    channelModeComboBox(*audioProcessor.apvts.getParameter("Channel Mode")),
+    oversamplingComboBox(*audioProcessor.apvts.getParameter("Oversampling")),
+    oversamplingFilterComboBox(*audioProcessor.apvts.getParameter("Oversampling Filter")),
+    filterStructureComboBox(*audioProcessor.apvts.getParameter("Filter Structure")),
+    filterDesignComboBox(*audioProcessor.apvts.getParameter("Filter Design")),
+    phaseModeComboBox(*audioProcessor.apvts.getParameter("Phase Mode")),
+    linearPhaseLengthComboBox(*audioProcessor.apvts.getParameter("Linear Phase Length")),
 
     responsiveCurveComponent(audioProcessor),
-    peakFreqSliderAttachment(audioProcessor.apvts, "Peak Freq", peakFreqSlider),
-    peakGainSliderAttachment(audioProcessor.apvts, "Peak Gain", peakGainSlider),
-    peakQualitySliderAttachment(audioProcessor.apvts, "Peak Quality", peakQualitySlider),
-    lowCutFreqSliderAttachment(audioProcessor.apvts, "LowCut Freq", lowCutFreqSlider),
-    highCutFreqSliderAttachment(audioProcessor.apvts, "HighCut Freq", highCutFreqSlider),
-    lowCutSlopeSliderAttachment(audioProcessor.apvts, "LowCut Slope", lowCutSlopeSlider),
-    highCutSlopeSliderAttachment(audioProcessor.apvts, "HighCut Slope", highCutSlopeSlider)
+    peakThresholdSliderAttachment(audioProcessor.apvts, "Peak Threshold", peakThresholdSlider),
+    peakRatioSliderAttachment(audioProcessor.apvts, "Peak Ratio", peakRatioSlider),
+    peakAttackSliderAttachment(audioProcessor.apvts, "Peak Attack", peakAttackSlider),
+    peakReleaseSliderAttachment(audioProcessor.apvts, "Peak Release", peakReleaseSlider),
+    peakDetectorComboBoxAttachment(audioProcessor.apvts, "Peak Detector", peakDetectorComboBox),
+    channelModeComboBoxAttachment(audioProcessor.apvts, "Channel Mode", channelModeComboBox),
+    oversamplingComboBoxAttachment(audioProcessor.apvts, "Oversampling", oversamplingComboBox),
+    oversamplingFilterComboBoxAttachment(audioProcessor.apvts, "Oversampling Filter", oversamplingFilterComboBox),
+    filterStructureComboBoxAttachment(audioProcessor.apvts, "Filter Structure", filterStructureComboBox),
+    filterDesignComboBoxAttachment(audioProcessor.apvts, "Filter Design", filterDesignComboBox),
+    phaseModeComboBoxAttachment(audioProcessor.apvts, "Phase Mode", phaseModeComboBox),
+    linearPhaseLengthComboBoxAttachment(audioProcessor.apvts, "Linear Phase Length", linearPhaseLengthComboBox)
 {
     for(auto* comp : getComps()) {
-        addAndMakeVisible(comp);
+        addControl(*comp);
     }
     
-    setSize (600, 400);
+    for(int k = 0; k < maxBands; k++)
+        bandSelector.addItem("Band " + juce::String(k + 1), k + 1);
+    
+    bandSelector.onChange = [this] { selectBand(bandSelector.getSelectedItemIndex()); };
+    bandSelector.setSelectedItemIndex(0, juce::dontSendNotification);
+    addControl(bandSelector);
+    
+    //the second set only takes effect in the left/right and mid/side modes
+    channelSetSelector.addItemList({ "Left / Mid", "Right / Side" }, 1);
+    channelSetSelector.onChange = [this] { selectChannelSet(channelSetSelector.getSelectedItemIndex()); };
+    channelSetSelector.setSelectedItemIndex(0, juce::dontSendNotification);
+    addControl(channelSetSelector);
+    selectChannelSet(0);
+    
+   #if FILTERPLUGIN_PROFILING
+    addAndMakeVisible(profilerOverlay);
+   #endif
+    
+    //the black fill covers the whole editor, so the host's window behind it is never painted
+    setOpaque(true);
+    setSize (600, 560);
+}
+
+void FilterPluginAudioProcessorEditor::selectChannelSet(int set)
+{
+    auto& apvts = audioProcessor.apvts;
+    editedChannelSet = set;
+    
+    for(auto* attachment : { &peakFreqSliderAttachment, &peakGainSliderAttachment, &peakQualitySliderAttachment,
+                             &lowCutFreqSliderAttachment, &highCutFreqSliderAttachment, &lowCutSlopeSliderAttachment, &highCutSlopeSliderAttachment })
+        attachment->reset();
+    
+    auto makeSlider = [&](std::unique_ptr<RotarySliderWithLabels>& slider, std::unique_ptr<Attachment>& attachment, const juce::String& name, const juce::String& suffix) {
+        const auto id = getChannelParameterID(set, name);
+        slider = std::make_unique<RotarySliderWithLabels>(*apvts.getParameter(id), suffix);
+        attachment = std::make_unique<Attachment>(apvts, id, *slider);
+        addControl(*slider);
+    };
+    
+    makeSlider(peakFreqSlider, peakFreqSliderAttachment, "Peak Freq", "Hz");
+    makeSlider(peakGainSlider, peakGainSliderAttachment, "Peak Gain", "dB");
+    makeSlider(peakQualitySlider, peakQualitySliderAttachment, "Peak Quality", "");
+    makeSlider(lowCutFreqSlider, lowCutFreqSliderAttachment, "LowCut Freq", "Hz");
+    makeSlider(highCutFreqSlider, highCutFreqSliderAttachment, "HighCut Freq", "Hz");
+    makeSlider(lowCutSlopeSlider, lowCutSlopeSliderAttachment, "LowCut Slope", "db/Oct");
+    makeSlider(highCutSlopeSlider, highCutSlopeSliderAttachment, "HighCut Slope", "db/Oct");
+    
+    responsiveCurveComponent.setChannelSet(set);
+    selectBand(juce::jmax(0, bandSelector.getSelectedItemIndex()));
+}
+
+void FilterPluginAudioProcessorEditor::selectBand(int band)
+{
+    auto& apvts = audioProcessor.apvts;
+    const auto set = editedChannelSet;
+    
+    //attachments go before the controls they are attached to
+    bandTypeComboBoxAttachment.reset();
+    bandFreqSliderAttachment.reset();
+    bandGainSliderAttachment.reset();
+    bandQualitySliderAttachment.reset();
+    
+    bandTypeComboBox = std::make_unique<ChoiceComboBox>(*apvts.getParameter(getBandParameterID(band, "Type", set)));
+    bandFreqSlider = std::make_unique<RotarySliderWithLabels>(*apvts.getParameter(getBandParameterID(band, "Freq", set)), "Hz");
+    bandGainSlider = std::make_unique<RotarySliderWithLabels>(*apvts.getParameter(getBandParameterID(band, "Gain", set)), "dB");
+    bandQualitySlider = std::make_unique<RotarySliderWithLabels>(*apvts.getParameter(getBandParameterID(band, "Quality", set)), "");
+    
+    bandTypeComboBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(apvts, getBandParameterID(band, "Type", set), *bandTypeComboBox);
+    bandFreqSliderAttachment = std::make_unique<Attachment>(apvts, getBandParameterID(band, "Freq", set), *bandFreqSlider);
+    bandGainSliderAttachment = std::make_unique<Attachment>(apvts, getBandParameterID(band, "Gain", set), *bandGainSlider);
+    bandQualitySliderAttachment = std::make_unique<Attachment>(apvts, getBandParameterID(band, "Quality", set), *bandQualitySlider);
+    
+    for(auto* comp : std::initializer_list<juce::Component*> { bandTypeComboBox.get(), bandFreqSlider.get(), bandGainSlider.get(), bandQualitySlider.get() })
+        addControl(*comp);
+    
+    resized();
 }
 
 FilterPluginAudioProcessorEditor::~FilterPluginAudioProcessorEditor()
 {
 }
 
+void FilterPluginAudioProcessorEditor::addControl(juce::Component& control)
+{
+    //the curve repaints at the analyser's rate, buffering it would only add a copy
+    control.setBufferedToImage(bufferedCompositing && &control != &responsiveCurveComponent);
+    addAndMakeVisible(control);
+}
+
+void FilterPluginAudioProcessorEditor::setBufferedCompositing(bool shouldBuffer)
+{
+    bufferedCompositing = shouldBuffer;
+    
+    for(auto* child : getChildren()) {
+       #if FILTERPLUGIN_PROFILING
+        if(child == &profilerOverlay)
+            continue;
+       #endif
+        
+        child->setBufferedToImage(bufferedCompositing && child != &responsiveCurveComponent);
+    }
+}
+
 void FilterPluginAudioProcessorEditor::paint (juce::Graphics& g)
 {
     using namespace juce;
-    g.fillAll (Colours::black);
     
-    auto bounds = getLocalBounds();
-    auto responseArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
+   #if FILTERPLUGIN_PROFILING
+    PaintTimer::Scope paintScope(PaintTimer::getInstance());
+   #endif
+    
+    //clipped to the invalidated region; the curve is opaque and never reaches here
+    g.fillAll (Colours::black);
 }
 
 void FilterPluginAudioProcessorEditor::resized()
@@ -278,32 +598,74 @@ void FilterPluginAudioProcessorEditor::resized()
     
     responsiveCurveComponent.setBounds(responseArea);
     
+   #if FILTERPLUGIN_PROFILING
+    profilerOverlay.setBounds(responseArea);
+   #endif
+    
     bounds.setBounds(bounds.getX(), bounds.getY() + 10, bounds.getWidth(), bounds.getHeight());
     
+    auto optionsArea = bounds.removeFromBottom(24).reduced(4, 0);
+    const auto optionWidth = optionsArea.getWidth() / 8;
+    
+    channelModeComboBox.setBounds(optionsArea.removeFromLeft(optionWidth).reduced(2, 0));
+    channelSetSelector.setBounds(optionsArea.removeFromLeft(optionWidth).reduced(2, 0));
+    oversamplingComboBox.setBounds(optionsArea.removeFromLeft(optionWidth).reduced(2, 0));
+    oversamplingFilterComboBox.setBounds(optionsArea.removeFromLeft(optionWidth).reduced(2, 0));
+    filterStructureComboBox.setBounds(optionsArea.removeFromLeft(optionWidth).reduced(2, 0));
+    filterDesignComboBox.setBounds(optionsArea.removeFromLeft(optionWidth).reduced(2, 0));
+    phaseModeComboBox.setBounds(optionsArea.removeFromLeft(optionWidth).reduced(2, 0));
+    linearPhaseLengthComboBox.setBounds(optionsArea.reduced(2, 0));
+    
+    //dynamic peak: four knobs and the detector source
+    auto dynamicsArea = bounds.removeFromBottom(80);
+    const auto dynamicsWidth = dynamicsArea.getWidth() / 5;
+    
+    peakThresholdSlider.setBounds(dynamicsArea.removeFromLeft(dynamicsWidth));
+    peakRatioSlider.setBounds(dynamicsArea.removeFromLeft(dynamicsWidth));
+    peakAttackSlider.setBounds(dynamicsArea.removeFromLeft(dynamicsWidth));
+    peakReleaseSlider.setBounds(dynamicsArea.removeFromLeft(dynamicsWidth));
+    peakDetectorComboBox.setBounds(dynamicsArea.withSizeKeepingCentre(dynamicsArea.getWidth() - 8, 24));
+    
+    //parametric bands: band and type selectors, then the selected band's knobs
+    auto bandArea = bounds.removeFromBottom(80);
+    const auto bandWidth = bandArea.getWidth() / 5;
+    auto selectorArea = bandArea.removeFromLeft(bandWidth).reduced(4, 0);
+    
+    bandSelector.setBounds(selectorArea.removeFromTop(selectorArea.getHeight() / 2).withSizeKeepingCentre(selectorArea.getWidth(), 24));
+    bandTypeComboBox->setBounds(selectorArea.withSizeKeepingCentre(selectorArea.getWidth(), 24));
+    bandFreqSlider->setBounds(bandArea.removeFromLeft(bandWidth));
+    bandGainSlider->setBounds(bandArea.removeFromLeft(bandWidth));
+    bandQualitySlider->setBounds(bandArea.removeFromLeft(bandWidth));
+    
     auto lowCutArea = bounds.removeFromLeft(bounds.getWidth() * 0.33);
     auto rightCutArea = bounds.removeFromRight(bounds.getWidth() * 0.5);
     
-    lowCutFreqSlider.setBounds(lowCutArea.removeFromTop(lowCutArea.getHeight() * 0.5));
-    highCutFreqSlider.setBounds(rightCutArea.removeFromTop(rightCutArea.getHeight() * 0.5));
+    lowCutFreqSlider->setBounds(lowCutArea.removeFromTop(lowCutArea.getHeight() * 0.5));
+    highCutFreqSlider->setBounds(rightCutArea.removeFromTop(rightCutArea.getHeight() * 0.5));
     
-    lowCutSlopeSlider.setBounds(lowCutArea);
-    highCutSlopeSlider.setBounds(rightCutArea);
+    lowCutSlopeSlider->setBounds(lowCutArea);
+    highCutSlopeSlider->setBounds(rightCutArea);
     
-    peakFreqSlider.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.33));
-    peakGainSlider.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.5));
-    peakQualitySlider.setBounds(bounds);
+    peakFreqSlider->setBounds(bounds.removeFromTop(bounds.getHeight() * 0.33));
+    peakGainSlider->setBounds(bounds.removeFromTop(bounds.getHeight() * 0.5));
+    peakQualitySlider->setBounds(bounds);
 }
 
 std::vector<juce::Component*> FilterPluginAudioProcessorEditor::getComps()
 {
     return {
-        &peakFreqSlider,
-        &peakGainSlider,
-        &peakQualitySlider,
-        &lowCutFreqSlider,
-        &highCutFreqSlider,
-        &lowCutSlopeSlider,
-        &highCutSlopeSlider,
+        &peakThresholdSlider,
+        &peakRatioSlider,
+        &peakAttackSlider,
+        &peakReleaseSlider,
+        &peakDetectorComboBox,
+        &channelModeComboBox,
+        &oversamplingComboBox,
+        &oversamplingFilterComboBox,
+        &filterStructureComboBox,
+        &filterDesignComboBox,
+        &phaseModeComboBox,
+        &linearPhaseLengthComboBox,
         &responsiveCurveComponent
     };
 }
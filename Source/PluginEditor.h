@@ -1,14 +1,56 @@
 #pragma once
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "ResponseCurve.h"
 
 struct LookAndFeel : juce::LookAndFeel_V4
 {
     void drawRotarySlider (juce::Graphics&, int x, int y, int width, int height,
                            float sliderPosProportional, float rotaryStartAngle,
                            float rotaryEndAngle, juce::Slider&) override;
+    
+    //the parts of drawRotarySlider: the body never changes with the value, so it can be cached
+    static void drawRotaryBody(juce::Graphics&, juce::Rectangle<float> bounds);
+    static void drawRotaryPointerAndLabel(juce::Graphics&, juce::Rectangle<float> bounds, float angle,
+                                          int textHeight, const juce::String& text, float textWidth);
 };
 
+#if FILTERPLUGIN_PROFILING
+//Time the editors spend painting, to verify drawing changes: one instance for the process,
+//as every editor paints on the message thread. Read and reset by the profiler overlay.
+class PaintTimer
+{
+public:
+    struct Scope
+    {
+        explicit Scope(PaintTimer& t) : timer(t), start(juce::Time::getMillisecondCounterHiRes()) { }
+        ~Scope() { timer.add(juce::Time::getMillisecondCounterHiRes() - start); }
+        
+        PaintTimer& timer;
+        double start;
+    };
+    
+    struct Snapshot
+    {
+        int numPaints { 0 };
+        double averageMicroseconds { 0 }, worstMicroseconds { 0 };
+        //share of the interval spent painting
+        double busyFraction { 0 };
+    };
+    
+    static PaintTimer& getInstance();
+    
+    void add(double milliseconds) noexcept;
+    //since the last snapshot
+    Snapshot takeSnapshot() noexcept;
+    
+private:
+    int numPaints { 0 };
+    double totalMilliseconds { 0 }, worstMilliseconds { 0 };
+    double intervalStart { juce::Time::getMillisecondCounterHiRes() };
+};
+#endif
+
 struct RotarySliderWithLabels: juce::Slider
 {
 public:
@@ -26,6 +68,7 @@ public:
     }
     
     void paint(juce::Graphics& g) override;
+    void resized() override;
     juce::Rectangle<int> getSliderBounds() const;
     int getTextHeight() const { return 14; }
     juce::String getDisplayString() const;
@@ -34,6 +77,24 @@ private:
     
     juce::RangedAudioParameter *param;
     juce::String suffix;
+    
+    //the body rendered once per size and display scale, the pointer and label drawn over it
+    juce::Image bodyImage;
+    float bodyImageScale { 0.0f };
+    //label text and width, measured when the value has changed instead of on every paint
+    juce::String displayString;
+    float displayStringWidth { 0.0f };
+    double displayedValue { std::numeric_limits<double>::quiet_NaN() };
+};
+
+//combo box listing the choices of an AudioParameterChoice, filled before its attachment is made
+struct ChoiceComboBox : juce::ComboBox
+{
+    ChoiceComboBox(juce::RangedAudioParameter& rap)
+    {
+        if(auto* choice = dynamic_cast<juce::AudioParameterChoice*>(&rap))
+            addItemList(choice->choices, 1);
+    }
 };
 
 struct ResponsiveCurveComponent : public juce::Component,
@@ -48,13 +109,58 @@ public:
     void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override { };
     void timerCallback() override;
     void paint (juce::Graphics&) override;
+    void resized() override;
+    
+    //which channel set the curve shows
+    void setChannelSet(int set);
     
 private:
     FilterPluginAudioProcessor& audioProcessor;
     
-    MonoChain monoChain;
+    int channelSet { 0 };
+    ChainCoefficients chainCoefficients;
+    //the processor's designs of the same settings are usually in here already
+    juce::SharedResourcePointer<CoefficientCache> coefficientCache;
     juce::Atomic<bool> parametersChanged { false };
+    
+    //magnitudes per pixel column, re-evaluated only when coefficients, size or sample rate change
+    ResponseCurve responseCurve;
+    juce::Path responseCurvePath;
+    double curveSampleRate { 0.0 };
+    
+    //input and output spectrum drawn behind the curve
+    std::array<juce::Path, SpectrumAnalyser::numTaps> spectrumPaths;
+    
+    static constexpr float curveStrokeWidth { 2.0f }, spectrumStrokeWidth { 1.0f };
+    
+    //black, the grid and the border, rendered once per size and display scale
+    juce::Image backgroundImage;
+    float backgroundImageScale { 0.0f };
+    
+    void updateResponseCurve(bool force);
+    //returns the area the old and new paths cover, the part that needs repainting
+    juce::Rectangle<int> updateSpectrumPaths(const SpectrumAnalyser::Spectrum& spectrum);
+    void renderBackground(float scale);
+    //pixels a stroked path of the given bounds can touch
+    static juce::Rectangle<int> getStrokedArea(juce::Rectangle<float> pathBounds, float strokeWidth);
+};
+
+#if FILTERPLUGIN_PROFILING
+//block load, per-section times and the load histogram, drawn over the response curve
+struct ProfilerOverlay : juce::Component,
+juce::Timer
+{
+public:
+    ProfilerOverlay(Profiler&);
+    void timerCallback() override;
+    void paint (juce::Graphics&) override;
+    
+private:
+    Profiler& profiler;
+    Profiler::Snapshot snapshot;
+    PaintTimer::Snapshot paintSnapshot;
 };
+#endif
 
 class FilterPluginAudioProcessorEditor  : public juce::AudioProcessorEditor
 {
@@ -63,31 +169,71 @@ public:
     ~FilterPluginAudioProcessorEditor() override;
     void paint (juce::Graphics&) override;
     void resized() override;
+    
+    //keeps every control but the response curve in an image of its own (setBufferedToImage),
+    //so repainting a neighbour only composites them; off by default, it costs an image per control
+    void setBufferedCompositing(bool shouldBuffer);
 
 private:
     FilterPluginAudioProcessor& audioProcessor;
+    bool bufferedCompositing { false };
     
-    RotarySliderWithLabels peakFreqSlider,
-    peakGainSlider,
-    peakQualitySlider,
-    lowCutFreqSlider,
-    highCutFreqSlider,
-    lowCutSlopeSlider,
-    highCutSlopeSlider;
+    RotarySliderWithLabels peakThresholdSlider,
+    peakRatioSlider,
+    peakAttackSlider,
+    peakReleaseSlider;
+    
+    ChoiceComboBox peakDetectorComboBox,
+    channelModeComboBox,
+    oversamplingComboBox,
+    oversamplingFilterComboBox,
+    filterStructureComboBox,
+    filterDesignComboBox,
+    phaseModeComboBox,
+    linearPhaseLengthComboBox;
     
     ResponsiveCurveComponent responsiveCurveComponent;
     
+   #if FILTERPLUGIN_PROFILING
+    ProfilerOverlay profilerOverlay { audioProcessor.getProfiler() };
+   #endif
+    
     using APVTS = juce::AudioProcessorValueTreeState;
     using Attachment = APVTS::SliderAttachment;
     
-    Attachment peakFreqSliderAttachment,
-    peakGainSliderAttachment,
-    peakQualitySliderAttachment,
-    lowCutFreqSliderAttachment,
-    highCutFreqSliderAttachment,
-    lowCutSlopeSliderAttachment,
-    highCutSlopeSliderAttachment;
+    Attachment peakThresholdSliderAttachment,
+    peakRatioSliderAttachment,
+    peakAttackSliderAttachment,
+    peakReleaseSliderAttachment;
+    
+    APVTS::ComboBoxAttachment peakDetectorComboBoxAttachment,
+    channelModeComboBoxAttachment,
+    oversamplingComboBoxAttachment,
+    oversamplingFilterComboBoxAttachment,
+    filterStructureComboBoxAttachment,
+    filterDesignComboBoxAttachment,
+    phaseModeComboBoxAttachment,
+    linearPhaseLengthComboBoxAttachment;
+    
+    //cut and peak controls, rebuilt for whichever channel set is being edited
+    juce::ComboBox channelSetSelector;
+    int editedChannelSet { 0 };
+    std::unique_ptr<RotarySliderWithLabels> peakFreqSlider, peakGainSlider, peakQualitySlider,
+    lowCutFreqSlider, highCutFreqSlider, lowCutSlopeSlider, highCutSlopeSlider;
+    std::unique_ptr<Attachment> peakFreqSliderAttachment, peakGainSliderAttachment, peakQualitySliderAttachment,
+    lowCutFreqSliderAttachment, highCutFreqSliderAttachment, lowCutSlopeSliderAttachment, highCutSlopeSliderAttachment;
+    
+    //one set of band controls, rebuilt for whichever band is selected
+    juce::ComboBox bandSelector;
+    std::unique_ptr<ChoiceComboBox> bandTypeComboBox;
+    std::unique_ptr<RotarySliderWithLabels> bandFreqSlider, bandGainSlider, bandQualitySlider;
+    std::unique_ptr<APVTS::ComboBoxAttachment> bandTypeComboBoxAttachment;
+    std::unique_ptr<Attachment> bandFreqSliderAttachment, bandGainSliderAttachment, bandQualitySliderAttachment;
     
+    void selectChannelSet(int set);
+    void selectBand(int band);
+    //adds a control, buffered if compositing is on
+    void addControl(juce::Component& control);
     std::vector<juce::Component*> getComps();
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FilterPluginAudioProcessorEditor)
@@ -7,16 +7,32 @@ FilterPluginAudioProcessor::FilterPluginAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    for(auto* parameter : getParameters())
+        if(auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            parametersByHash.emplace_back(getParameterIDHash(ranged->paramID), ranged);
+    
+    std::sort(parametersByHash.begin(), parametersByHash.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    
+    //the binary state identifies parameters by hash only
+    jassert(std::adjacent_find(parametersByHash.begin(), parametersByHash.end(),
+                               [](const auto& a, const auto& b) { return a.first == b.first; }) == parametersByHash.end());
+    
+    latencyNotifier->add(this);
 }
 
 FilterPluginAudioProcessor::~FilterPluginAudioProcessor()
 {
+    latencyNotifier->remove(this);
+    
+    //in case the host never called releaseResources
+    channelWorkers->release(this);
 }
 const juce::String FilterPluginAudioProcessor::getName() const
 {
@@ -57,21 +73,34 @@ double FilterPluginAudioProcessor::getTailLengthSeconds() const
 
 int FilterPluginAudioProcessor::getNumPrograms()
 {
-    return 1;
+    return presetBank.getNumPresets();
 }
 
 int FilterPluginAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void FilterPluginAudioProcessor::setCurrentProgram (int index)
 {
+    if(!juce::isPositiveAndBelow(index, presetBank.getNumPresets()))
+        return;
+    
+    //the audio thread fades to the precomputed design on its next block; the parameters follow
+    //for the editor and host, and the updater's design of them matches what is already running.
+    //Designs begun before, or while the parameters were half applied, are dropped, and so are the
+    //listeners' automation events, which would ramp the running chain towards the half-applied program
+    currentProgram = index;
+    automationEvents.setIgnoringListenerChanges(true);
+    presetBank.applyParameters(index, apvts);
+    automationEvents.setIgnoringListenerChanges(false);
+    coefficientUpdater.beginProgram();
+    pendingProgram.store(index);
 }
 
 const juce::String FilterPluginAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return presetBank.getName(index);
 }
 
 void FilterPluginAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -79,21 +108,168 @@ void FilterPluginAudioProcessor::changeProgramName (int index, const juce::Strin
 }
 void FilterPluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
-    spec.sampleRate = sampleRate;
+    currentSampleRate = sampleRate;
     
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    const auto numChannels = juce::jmax(getMainBusNumInputChannels(), getMainBusNumOutputChannels());
+    channelChain.prepare(numChannels);
+    stateVariableChain.prepare(numChannels);
+    doubleChain.prepare(numChannels);
+    fadeChannelChain.prepare(numChannels);
+    fadeStateVariableChain.prepare(numChannels);
+    fadeDoubleChain.prepare(numChannels);
+    
+    //the fade copy holds a whole block at the highest oversampling factor, longer ones run in pieces
+    const auto fadeBufferLength = samplesPerBlock << maxOversamplingOrder;
+    
+    if(isUsingDoublePrecision()) {
+        doubleOversampling.prepare(numChannels, samplesPerBlock);
+        oversampling.release();
+        doubleFadeBuffer.setSize(numChannels, fadeBufferLength);
+        fadeBuffer.setSize(0, 0);
+        doubleRateFadeBuffer.setSize(numChannels, samplesPerBlock);
+        rateFadeBuffer.setSize(0, 0);
+    }
+    else {
+        oversampling.prepare(numChannels, samplesPerBlock);
+        doubleOversampling.release();
+        fadeBuffer.setSize(numChannels, fadeBufferLength);
+        doubleFadeBuffer.setSize(0, 0);
+        rateFadeBuffer.setSize(numChannels, samplesPerBlock);
+        doubleRateFadeBuffer.setSize(0, 0);
+    }
     
-    auto chainSettings = getChainSettings(apvts);
+    //the parameters of a program chosen before now are designed below like any other
+    presetBank.prepare(sampleRate);
+    pendingProgram.store(-1);
+    presetFadeRemaining = 0;
+    rateFadeRemaining = 0;
     
+    //forces updateFilters to select the oversampler again
+    activeOversampling.order = -1;
+    
+    linearPhaseEngine.prepare(numChannels);
+    linearPhaseActive = false;
+    
+    dynamicPeak.prepare(sampleRate, samplesPerBlock);
+    
+    //normalised to the sample rate, so only a new resolution rebuilds it
+    if(coefficientTable.getSegmentsPerOctave() != coefficientTableResolution.load())
+        coefficientTable.prepare(coefficientTableResolution.load());
+    
+    //one worker fewer than groups, the audio thread runs a group itself
+    const auto numGroups = isUsingDoublePrecision() ? SIMDChainDouble::getNumGroups(numChannels) : SIMDChain::getNumGroups(numChannels);
+    const auto numWorkers = juce::jmin(maxChannelWorkers.load(), numGroups - 1, juce::SystemStats::getNumCpus() - 1);
+    
+    channelWorkers->prepare(this, juce::jmax(0, numWorkers));
+    
+    coefficientUpdater.prepare(sampleRate, numChannels);
+    analyser.prepare(sampleRate);
+    profiler.prepare(sampleRate);
+    
+    //the first update selects the processing mode and prepares the smoother for its rate
     updateFilters();
+    
+    if(linearPhaseActive)
+        linearPhaseEngine.update();
+    
+    latencySamples.store(getProcessingLatency());
+    setLatencySamples(latencySamples.load());
+}
+
+void FilterPluginAudioProcessor::setOversampling(const OversamplingSettings& settings, bool keepOutgoing) noexcept {
+    
+    activeOversampling = settings;
+    processingSampleRate = currentSampleRate * (1 << settings.order);
+    
+    //neutral stages fade in and out over the same time at every rate
+    const auto fadeLength = juce::roundToInt(processingSampleRate * stageFadeTime);
+    channelChain.setFadeLength(fadeLength);
+    stateVariableChain.setFadeLength(fadeLength);
+    doubleChain.setFadeLength(fadeLength);
+    fadeChannelChain.setFadeLength(fadeLength);
+    fadeStateVariableChain.setFadeLength(fadeLength);
+    fadeDoubleChain.setFadeLength(fadeLength);
+    
+    if(isUsingDoublePrecision())
+        doubleOversampling.select(settings, keepOutgoing);
+    else
+        oversampling.select(settings, keepOutgoing);
+}
+
+void FilterPluginAudioProcessor::startRateFade(const CoefficientUpdate& update, bool wasStateVariable) noexcept {
+    
+    //a fade still running is cut short; the running chain keeps its state and coefficients at the old rate
+    if(isUsingDoublePrecision())
+        std::swap(doubleChain, fadeDoubleChain);
+    else if(wasStateVariable)
+        std::swap(stateVariableChain, fadeStateVariableChain);
+    else
+        std::swap(channelChain, fadeChannelChain);
+    
+    rateFadeStateVariable = wasStateVariable;
+    presetFadeRemaining = 0;
+    
+    setOversampling(update.oversampling, true);
+    
+    for(int set = 0; set < numChannelSets; set++)
+        chainSmoothers[(size_t) set].prepare(processingSampleRate, smoothingTime.load(), update.settings[(size_t) set]);
+    
+    resetChains();
+    setChainCoefficients(update.coefficients, update.independent);
+    
+    rateFadeLength = juce::jmax(1, juce::roundToInt(currentSampleRate * presetFadeTime));
+    rateFadeRemaining = rateFadeLength;
+}
+
+int FilterPluginAudioProcessor::getProcessingLatency() const noexcept {
+    
+    if(linearPhaseActive)
+        return linearPhaseEngine.getLatencySamples();
+    
+    return isUsingDoublePrecision() ? doubleOversampling.getLatencySamples() : oversampling.getLatencySamples();
+}
+
+void LatencyNotifier::add(FilterPluginAudioProcessor* processor) {
+    
+    processors.push_back(processor);
+    
+    if(!isTimerRunning())
+        startTimerHz(10);
+}
+
+void LatencyNotifier::remove(FilterPluginAudioProcessor* processor) {
+    
+    processors.erase(std::remove(processors.begin(), processors.end(), processor), processors.end());
+    
+    if(processors.empty())
+        stopTimer();
+}
+
+void LatencyNotifier::timerCallback() {
+    
+    for(auto* processor : processors)
+        processor->updateHostLatency();
+}
+
+void FilterPluginAudioProcessor::updateHostLatency() {
+    
+    const auto latency = latencySamples.load();
+    if(latency != getLatencySamples())
+        setLatencySamples(latency);
+}
+
+double FilterPluginAudioProcessor::getFilterSampleRate() {
+    
+    if(apvts.getRawParameterValue("Phase Mode")->load() > 0.5f)
+        return getSampleRate();
+    
+    return getSampleRate() * (1 << getOversamplingSettings(apvts).order);
 }
 
 void FilterPluginAudioProcessor::releaseResources()
 {
+    coefficientUpdater.release();
+    channelWorkers->release(this);
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -103,8 +279,8 @@ bool FilterPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layo
     juce::ignoreUnused (layouts);
     return true;
   #else
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    //any layout works, every channel gets the same filters; the sidechain may have any layout or be off
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
@@ -116,8 +292,87 @@ bool FilterPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layo
 }
 #endif
 
-void FilterPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+bool FilterPluginAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template<>
+OversamplingStage<float>& FilterPluginAudioProcessor::getOversamplingStage<float>() noexcept { return oversampling; }
+
+template<>
+OversamplingStage<double>& FilterPluginAudioProcessor::getOversamplingStage<double>() noexcept { return doubleOversampling; }
+
+template<>
+juce::AudioBuffer<float>& FilterPluginAudioProcessor::getRateFadeBuffer<float>() noexcept { return rateFadeBuffer; }
+
+template<>
+juce::AudioBuffer<double>& FilterPluginAudioProcessor::getRateFadeBuffer<double>() noexcept { return doubleRateFadeBuffer; }
+
+template<typename SampleType>
+void FilterPluginAudioProcessor::processOutgoingRate(const juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) noexcept
 {
+    auto& outgoing = getRateFadeBuffer<SampleType>();
+    auto& oversamplingStage = getOversamplingStage<SampleType>();
+    
+    for(int channel = 0; channel < numChannels; channel++)
+        outgoing.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+    
+    //without an outgoing oversampler the old path ran at the host rate
+    if(oversamplingStage.hasOutgoing())
+        oversamplingStage.processOutgoing(outgoing.getArrayOfWritePointers(), numChannels, numSamples,
+                                          [this](SampleType* const* channels, int numOversampledChannels, int numOversampledSamples) {
+            runOutgoingChain(channels, numOversampledChannels, numOversampledSamples);
+        });
+    else
+        runOutgoingChain(outgoing.getArrayOfWritePointers(), numChannels, numSamples);
+    
+    oversamplingStage.alignOutgoing(outgoing.getArrayOfWritePointers(), numChannels, numSamples);
+}
+
+template<typename SampleType>
+void FilterPluginAudioProcessor::mixOutgoingRate(juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) noexcept
+{
+    const auto& outgoing = getRateFadeBuffer<SampleType>();
+    const auto step = SampleType(1) / (SampleType) rateFadeLength;
+    
+    //the lower latency side is delayed to the other's, so the two are mixed in phase
+    getOversamplingStage<SampleType>().alignActive(buffer.getArrayOfWritePointers(), numChannels, numSamples);
+    
+    for(int channel = 0; channel < numChannels; channel++) {
+        const auto* old = outgoing.getReadPointer(channel);
+        auto* samples = buffer.getWritePointer(channel);
+        auto oldGain = (SampleType) rateFadeRemaining * step;
+        
+        for(int i = 0; i < numSamples; i++, oldGain -= step)
+            samples[i] += (old[i] - samples[i]) * oldGain;
+    }
+    
+    //the rest of a block longer than the copy takes the new rate alone
+    rateFadeRemaining = numSamples < buffer.getNumSamples() ? 0 : rateFadeRemaining - numSamples;
+    
+    if(rateFadeRemaining == 0)
+        getOversamplingStage<SampleType>().endOutgoing();
+}
+
+void FilterPluginAudioProcessor::runOutgoingChain(float* const* channels, int numChannels, int numSamples) noexcept
+{
+    if(rateFadeStateVariable)
+        runChain(fadeStateVariableChain, channels, numChannels, 0, numSamples);
+    else
+        runChain(fadeChannelChain, channels, numChannels, 0, numSamples);
+}
+
+void FilterPluginAudioProcessor::runOutgoingChain(double* const* channels, int numChannels, int numSamples) noexcept
+{
+    runChain(fadeDoubleChain, channels, numChannels, 0, numSamples);
+}
+
+template<typename SampleType>
+void FilterPluginAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    RealtimeSafety::ScopedRealtimeCheck realtimeCheck;
+    Profiler::ScopedBlock profiledBlock(profiler, buffer.getNumSamples());
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -125,19 +380,427 @@ void FilterPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    updateFilters();
+    {
+        Profiler::ScopedTimer timer(profiler, ProfileSection_Update);
+        updateFilters();
+        loadPendingProgram();
+        
+        //linear phase follows the parameters through the updater only
+        if(linearPhaseActive)
+            automationEvents.clear();
+        else
+            automationEvents.collect(buffer.getNumSamples(), activeOversampling.order);
+    }
+    
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), channelChain.getNumChannels());
+    auto& oversamplingStage = getOversamplingStage<SampleType>();
+    
+    {
+        Profiler::ScopedTimer timer(profiler, ProfileSection_Analyser);
+        analyser.push(SpectrumAnalyser::PreFilter, buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples());
+    }
+    
+    chainPosition = 0;
+    
+    //an oversampling switch fades out the old rate's path, run first on a copy of the input
+    const auto rateFadeSamples = linearPhaseActive ? 0 : juce::jmin(rateFadeRemaining, buffer.getNumSamples(), getRateFadeBuffer<SampleType>().getNumSamples());
+    
+    if(rateFadeSamples > 0) {
+        Profiler::ScopedTimer timer(profiler, ProfileSection_Oversampling);
+        processOutgoingRate(buffer, numChannels, rateFadeSamples);
+    }
+    
+    if(!linearPhaseActive && dynamicPeak.getSettings().isActive()) {
+        Profiler::ScopedTimer timer(profiler, ProfileSection_Dynamics);
+        analyseDynamics(buffer, numChannels);
+    }
+    
+    if(linearPhaseActive) {
+        Profiler::ScopedTimer timer(profiler, ProfileSection_LinearPhase);
+        linearPhaseEngine.process(buffer.getArrayOfWritePointers(), numChannels, buffer.getNumSamples());
+    }
+    else if(oversamplingStage.isActive()) {
+        Profiler::ScopedTimer timer(profiler, ProfileSection_Oversampling);
+        oversamplingStage.process(buffer, numChannels, [this](SampleType* const* channels, int numOversampledChannels, int numSamples) {
+            processChains(channels, numOversampledChannels, numSamples);
+        });
+    }
+    //with every stage neutral and nothing ramping the block passes through untouched
+    else if(!isChainFlat() || isSmoothing() || dynamicPeak.getSettings().isActive() || presetFadeRemaining > 0 || automationEvents.hasEvents())
+        processChains(buffer.getArrayOfWritePointers(), numChannels, buffer.getNumSamples());
+    
+    if(rateFadeSamples > 0)
+        mixOutgoingRate(buffer, numChannels, rateFadeSamples);
+    else if(!linearPhaseActive)
+        oversamplingStage.keepOutput(buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples());
+    
+    latencySamples.store(getProcessingLatency());
+    
+    Profiler::ScopedTimer timer(profiler, ProfileSection_Analyser);
+    analyser.push(SpectrumAnalyser::PostFilter, buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples());
+}
+
+void FilterPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer);
+}
+
+void FilterPluginAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer);
+}
+
+template<typename SampleType>
+void FilterPluginAudioProcessor::analyseDynamics(juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept
+{
+    const auto useSidechain = dynamicPeak.getSettings().externalSidechain
+                           && getBusCount(true) > 1 && getChannelCountOfBus(true, 1) > 0;
+    
+    //without a connected sidechain the band of the main input drives the gain
+    if(useSidechain) {
+        auto sidechain = getBusBuffer(buffer, true, 1);
+        dynamicPeak.analyse(sidechain.getArrayOfReadPointers(), sidechain.getNumChannels(), sidechain.getNumSamples(),
+                            coefficientUpdateInterval.load(), false);
+    }
+    else {
+        dynamicPeak.analyse(buffer.getArrayOfReadPointers(), numChannels, buffer.getNumSamples(),
+                            coefficientUpdateInterval.load(), true);
+    }
+}
+
+template<typename SampleType>
+void FilterPluginAudioProcessor::processChains(SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    //same redesign rate per second of audio at every oversampling factor
+    const auto updateInterval = coefficientUpdateInterval.load() << activeOversampling.order;
+    const auto dynamic = dynamicPeak.getSettings().isActive();
+    const auto minSegmentLength = minAutomationSegmentLength << activeOversampling.order;
+    int start = 0;
+    
+    //automation events split the block into segments; each event retargets the ramps where it falls,
+    //together with any others due within the minimum segment length
+    while(start < numSamples) {
+        const auto position = chainPosition + start;
+        
+        if(automationEvents.apply(position + minSegmentLength - 1, automatedSettings, channelsLinked)) {
+            for(int set = 0; set < numChannelSets; set++)
+                chainSmoothers[(size_t) set].setTarget(automatedSettings[(size_t) set]);
+            
+            //a change with nothing to ramp (a slope or band type) is designed where it falls
+            if(!isSmoothing() && !(automatedSettings == targetSettings)) {
+                Profiler::ScopedTimer timer(profiler, ProfileSection_Redesign);
+                const auto independent = !(automatedSettings[1] == automatedSettings[0]);
+                
+                for(int set = 0; set < (independent ? numChannelSets : 1); set++)
+                    makeChainCoefficients(smoothedCoefficients[(size_t) set], automatedSettings[(size_t) set], processingSampleRate, &coefficientTable);
+                
+                setChainCoefficients(smoothedCoefficients, independent);
+                dynamicPeakDesigned = false;
+            }
+        }
+        
+        const auto end = automationEvents.hasEvents() ? juce::jmin(numSamples, automationEvents.getNextPosition() - chainPosition) : numSamples;
+        start = processChainSegment(channels, numChannels, start, end, updateInterval, dynamic);
+    }
+    
+    chainPosition += numSamples;
+}
+
+template<typename SampleType>
+int FilterPluginAudioProcessor::processChainSegment(SampleType* const* channels, int numChannels, int start, int end, int updateInterval, bool dynamic) noexcept
+{
+    //while a ramp is running the coefficients are redesigned every updateInterval samples,
+    //the second channel set only where it differs from the first
+    while(isSmoothing() && start < end) {
+        const auto length = juce::jmin(updateInterval, end - start);
+        
+        {
+            Profiler::ScopedTimer timer(profiler, ProfileSection_Redesign);
+            std::array<ChainSettings, numChannelSets> settings;
+            
+            for(int set = 0; set < numChannelSets; set++) {
+                settings[(size_t) set] = chainSmoothers[(size_t) set].advance(length);
+                
+                if(dynamic)
+                    settings[(size_t) set].peakGainInDecibels += getDynamicGainChange(start);
+            }
+            
+            const auto independent = !(settings[1] == settings[0]);
+            
+            //a ramp that has arrived at the updater's settings takes its direct design
+            if(!dynamic && !isSmoothing() && settings == targetSettings) {
+                setChainCoefficients(targetCoefficients, targetIndependent);
+            }
+            else {
+                for(int set = 0; set < (independent ? numChannelSets : 1); set++)
+                    makeChainCoefficients(smoothedCoefficients[(size_t) set], settings[(size_t) set], processingSampleRate, &coefficientTable);
+                
+                setChainCoefficients(smoothedCoefficients, independent);
+            }
+        }
+        
+        dynamicPeakDesigned = false;
+        processChain(channels, numChannels, start, length);
+        
+        start += length;
+    }
+    
+    //a dynamic peak is redesigned only once its gain has moved, in short segments while it moves fast
+    //and in one go over stretches of steady gain; the cuts keep the updater's design
+    const auto dynamicLength = dynamicSegmentLength << activeOversampling.order;
+    const auto detectorInterval = dynamicPeak.getUpdateInterval() << activeOversampling.order;
+    
+    while(dynamic && start < end) {
+        const auto gainChange = getDynamicGainChange(start);
+        auto length = juce::jmin(dynamicLength, end - start);
+        
+        auto isSteady = [&](int sample) { return std::abs(getDynamicGainChange(sample) - gainChange) < dynamicGainStep; };
+        
+        //the gain is linear up to each detector interval end, so a steady interval is checked at its
+        //first and last sample; the one it moves away in is walked dynamicLength samples at a time
+        while(start + length < end) {
+            const auto next = juce::jmin(end - start, length + detectorInterval - (chainPosition + start + length) % detectorInterval);
+            
+            if(isSteady(start + length) && isSteady(start + next - 1)) {
+                length = next;
+                continue;
+            }
+            
+            while(start + length < end && isSteady(start + length))
+                length = juce::jmin(length + dynamicLength, end - start);
+            
+            break;
+        }
+        
+        if(!dynamicPeakDesigned || std::abs(gainChange - designedGainChange) >= dynamicGainResolution) {
+            Profiler::ScopedTimer timer(profiler, ProfileSection_Redesign);
+            
+            for(int set = 0; set < (targetIndependent ? numChannelSets : 1); set++) {
+                auto settings = targetSettings[(size_t) set];
+                settings.peakGainInDecibels += gainChange;
+                smoothedCoefficients[(size_t) set] = targetCoefficients[(size_t) set];
+                makePeakFilter(smoothedCoefficients[(size_t) set].peak, settings, processingSampleRate, &coefficientTable);
+            }
+            
+            setChainCoefficients(smoothedCoefficients, targetIndependent);
+            
+            designedGainChange = gainChange;
+            dynamicPeakDesigned = true;
+        }
+        
+        processChain(channels, numChannels, start, length);
+        start += length;
+    }
     
-    juce::dsp::AudioBlock<float> block(buffer);
+    processChain(channels, numChannels, start, end - start);
+    return end;
+}
+
+float FilterPluginAudioProcessor::getDynamicGainChange(int startSample) const noexcept
+{
+    //the detector ran at the host rate
+    return dynamicPeak.getGainChange((chainPosition + startSample) >> activeOversampling.order);
+}
+
+bool FilterPluginAudioProcessor::isSmoothing() const noexcept
+{
+    return std::any_of(chainSmoothers.begin(), chainSmoothers.end(), [](const ChainSmoother& smoother) { return smoother.isSmoothing(); });
+}
+
+void FilterPluginAudioProcessor::setChainCoefficients(const std::array<ChainCoefficients, numChannelSets>& coefficients, bool independent) noexcept
+{
+    auto set = [&](auto& chain) {
+        if(independent)
+            chain.setCoefficients(coefficients[0], coefficients[1]);
+        else
+            chain.setCoefficients(coefficients[0]);
+    };
     
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    if(isUsingDoublePrecision())
+        set(doubleChain);
+    else if(stateVariableActive)
+        set(stateVariableChain);
+    else
+        set(channelChain);
+}
+
+void FilterPluginAudioProcessor::setMidSide(bool shouldUseMidSide) noexcept
+{
+    midSideActive = shouldUseMidSide;
+    channelChain.setMidSide(shouldUseMidSide);
+    stateVariableChain.setMidSide(shouldUseMidSide);
+    doubleChain.setMidSide(shouldUseMidSide);
+}
+
+bool FilterPluginAudioProcessor::isChainFlat() const noexcept
+{
+    if(isUsingDoublePrecision())
+        return doubleChain.isFlat();
     
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    return stateVariableActive ? stateVariableChain.isFlat() : channelChain.isFlat();
+}
+
+void FilterPluginAudioProcessor::processChain(float* const* channels, int numChannels, int startSample, int numSamples) noexcept
+{
+    Profiler::ScopedTimer timer(profiler, ProfileSection_Chain);
     
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    if(stateVariableActive && structureFade)
+        processPresetFade(stateVariableChain, channelChain, fadeBuffer, channels, numChannels, startSample, numSamples);
+    else if(stateVariableActive)
+        processPresetFade(stateVariableChain, fadeStateVariableChain, fadeBuffer, channels, numChannels, startSample, numSamples);
+    else if(structureFade)
+        processPresetFade(channelChain, stateVariableChain, fadeBuffer, channels, numChannels, startSample, numSamples);
+    else
+        processPresetFade(channelChain, fadeChannelChain, fadeBuffer, channels, numChannels, startSample, numSamples);
+}
 
+void FilterPluginAudioProcessor::processChain(double* const* channels, int numChannels, int startSample, int numSamples) noexcept
+{
+    Profiler::ScopedTimer timer(profiler, ProfileSection_Chain);
+    processPresetFade(doubleChain, fadeDoubleChain, doubleFadeBuffer, channels, numChannels, startSample, numSamples);
+}
+
+template<typename Chain, typename FadeChain, typename SampleType>
+void FilterPluginAudioProcessor::processPresetFade(Chain& chain, FadeChain& fadeChain, juce::AudioBuffer<SampleType>& buffer,
+                                                   SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+{
+    //the outgoing chain filters a copy of the input and is mixed out linearly
+    const auto fadeSamples = juce::jmin(numSamples, presetFadeRemaining);
+    
+    for(int done = 0; done < fadeSamples;) {
+        const auto length = juce::jmin(fadeSamples - done, buffer.getNumSamples());
+        const auto start = startSample + done;
+        
+        for(int channel = 0; channel < numChannels; channel++)
+            buffer.copyFrom(channel, 0, channels[channel] + start, length);
+        
+        runChain(fadeChain, buffer.getArrayOfWritePointers(), numChannels, 0, length);
+        runChain(chain, channels, numChannels, start, length);
+        
+        const auto step = SampleType(1) / (SampleType) presetFadeLength;
+        
+        for(int channel = 0; channel < numChannels; channel++) {
+            const auto* outgoing = buffer.getReadPointer(channel);
+            auto* samples = channels[channel] + start;
+            auto oldGain = (SampleType) presetFadeRemaining * step;
+            
+            for(int i = 0; i < length; i++, oldGain -= step)
+                samples[i] += (outgoing[i] - samples[i]) * oldGain;
+        }
+        
+        presetFadeRemaining -= length;
+        done += length;
+    }
+    
+    runChain(chain, channels, numChannels, startSample + fadeSamples, numSamples - fadeSamples);
+}
+
+template<typename Chain, typename SampleType>
+void FilterPluginAudioProcessor::runChain(Chain& chain, SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+{
+    const auto numGroups = Chain::getNumGroups(numChannels);
+    
+    if(channelWorkers->getNumWorkers() == 0 || numGroups < 2 || numSamples < parallelThreshold.load(std::memory_order_relaxed)) {
+        chain.process(channels, numChannels, startSample, numSamples);
+        return;
+    }
+    
+    auto task = [&](int group) { chain.processChannelGroup(group, channels, numChannels, startSample, numSamples); };
+    channelWorkers->run(numGroups, task);
+    chain.finishBlock(numSamples);
+}
+
+void FilterPluginAudioProcessor::loadPendingProgram() noexcept
+{
+    //a fade still running finishes first; the program stays pending, where a newer one can replace it
+    if(pendingProgram.load() < 0 || (!linearPhaseActive && (presetFadeRemaining > 0 || rateFadeRemaining > 0)))
+        return;
+    
+    const auto index = pendingProgram.exchange(-1);
+    
+    //the linear-phase engine crossfades its own kernels
+    if(index < 0 || linearPhaseActive)
+        return;
+    
+    const auto& design = presetBank.getDesign(index);
+    const auto stereo = channelChain.getNumChannels() == 2;
+    const auto independent = stereo && design.independent;
+    //the design mode is not part of a preset, the instance keeps its own
+    const auto designMode = targetSettings[0].designMode;
+    const auto& coefficients = design.coefficients[(size_t) designMode][(size_t) activeOversampling.order];
+    
+    //the running chain keeps its state and coefficients for the fade, the incoming one starts from silence
+    if(isUsingDoublePrecision())
+        std::swap(doubleChain, fadeDoubleChain);
+    else if(stateVariableActive)
+        std::swap(stateVariableChain, fadeStateVariableChain);
+    else
+        std::swap(channelChain, fadeChannelChain);
+    
+    setMidSide(stereo && design.channelMode == ChannelMode_MidSide);
+    resetChains();
+    setChainCoefficients(coefficients, independent);
+    
+    for(int set = 0; set < numChannelSets; set++) {
+        targetSettings[(size_t) set] = design.settings[independent ? (size_t) set : 0];
+        targetSettings[(size_t) set].designMode = designMode;
+        targetCoefficients[(size_t) set] = coefficients[independent ? (size_t) set : 0];
+        chainSmoothers[(size_t) set].prepare(processingSampleRate, smoothingTime.load(), targetSettings[(size_t) set]);
+    }
+    
+    targetIndependent = independent;
+    dynamicPeakDesigned = false;
+    automatedSettings = targetSettings;
+    channelsLinked = !stereo || design.channelMode == ChannelMode_Linked;
+    
+    loadedProgramGeneration = coefficientUpdater.getProgramGeneration();
+    presetFadeLength = juce::jmax(1, juce::roundToInt(processingSampleRate * presetFadeTime));
+    presetFadeRemaining = presetFadeLength;
+    structureFade = false;
+}
+
+void FilterPluginAudioProcessor::resetChains() noexcept
+{
+    channelChain.reset();
+    stateVariableChain.reset();
+    doubleChain.reset();
+}
+
+void FilterPluginAudioProcessor::setSmoothingTime(float seconds) noexcept
+{
+    smoothingTime.store(juce::jmax(0.0f, seconds));
+}
+
+void FilterPluginAudioProcessor::setCoefficientUpdateInterval(int numSamples) noexcept
+{
+    coefficientUpdateInterval.store(juce::jmax(1, numSamples));
+}
+
+void FilterPluginAudioProcessor::setChannelWorkers(int numWorkers) noexcept
+{
+    maxChannelWorkers.store(juce::jmax(0, numWorkers));
+}
+
+#if FILTERPLUGIN_AUDIO_WORKGROUPS
+void FilterPluginAudioProcessor::audioWorkgroupContextChanged(const juce::AudioWorkgroup& workgroup)
+{
+    channelWorkers->setWorkgroup(workgroup);
+}
+#endif
+
+void FilterPluginAudioProcessor::setParallelThreshold(int numSamples) noexcept
+{
+    parallelThreshold.store(juce::jmax(1, numSamples));
+}
+
+void FilterPluginAudioProcessor::addParameterEvent(int parameterIndex, float normalisedValue, int sampleOffset) noexcept
+{
+    automationEvents.add(parameterIndex, normalisedValue, sampleOffset);
+}
+
+void FilterPluginAudioProcessor::setCoefficientTableResolution(int segmentsPerOctave) noexcept
+{
+    coefficientTableResolution.store(juce::jmax(0, segmentsPerOctave));
 }
 bool FilterPluginAudioProcessor::hasEditor() const
 {
@@ -151,143 +814,328 @@ juce::AudioProcessorEditor* FilterPluginAudioProcessor::createEditor()
 
 void FilterPluginAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
+    //see PluginState.h for the layout
     juce::MemoryOutputStream moc(destData, true);
-    apvts.state.writeToStream(moc);
+    moc.writeInt((int) binaryStateMagic);
+    moc.writeShort((short) binaryStateVersion);
+    moc.writeShort((short) parametersByHash.size());
+    
+    for(const auto& parameter : parametersByHash) {
+        moc.writeInt((int) parameter.first);
+        moc.writeFloat(parameter.second->convertFrom0to1(parameter.second->getValue()));
+    }
 }
 
 void FilterPluginAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    std::vector<std::pair<juce::uint32, float>> values;
+    
+    if(readBinaryState(data, sizeInBytes, values)) {
+        std::sort(values.begin(), values.end());
+        
+        //only parameters that change notify their listeners; those missing from the state return to their defaults
+        for(const auto& parameter : parametersByHash) {
+            const auto value = std::lower_bound(values.begin(), values.end(), std::make_pair(parameter.first, -std::numeric_limits<float>::infinity()));
+            const auto normalised = value != values.end() && value->first == parameter.first
+                                  ? parameter.second->convertTo0to1(value->second)
+                                  : parameter.second->getDefaultValue();
+            
+            if(normalised != parameter.second->getValue())
+                parameter.second->setValueNotifyingHost(normalised);
+        }
+        
+        coefficientUpdater.markDirty();
+        return;
+    }
+    
+    //states saved before the binary format
     auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
     if(tree.isValid()) {
         apvts.replaceState(tree);
-        updateFilters();
+        coefficientUpdater.markDirty();
     }
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts) {
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts, int channelSet) {
     
     ChainSettings settings;
     
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
-    settings.peakGainInDecibels = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
+    auto get = [&](const juce::String& name) { return apvts.getRawParameterValue(getChannelParameterID(channelSet, name))->load(); };
+    
+    settings.lowCutFreq = get("LowCut Freq");
+    settings.highCutFreq = get("HighCut Freq");
+    settings.peakFreq = get("Peak Freq");
+    settings.peakQuality = get("Peak Quality");
+    settings.peakGainInDecibels = get("Peak Gain");
+    settings.lowCutSlope = static_cast<Slope>(get("LowCut Slope"));
+    settings.highCutSlope = static_cast<Slope>(get("HighCut Slope"));
+    settings.designMode = static_cast<DesignMode>(apvts.getRawParameterValue("Filter Design")->load());
+    
+    for(int k = 0; k < maxBands; k++) {
+        auto& band = settings.bands[k];
+        band.type = static_cast<BandType>(apvts.getRawParameterValue(getBandParameterID(k, "Type", channelSet))->load());
+        band.freq = apvts.getRawParameterValue(getBandParameterID(k, "Freq", channelSet))->load();
+        band.gainInDecibels = apvts.getRawParameterValue(getBandParameterID(k, "Gain", channelSet))->load();
+        band.quality = apvts.getRawParameterValue(getBandParameterID(k, "Quality", channelSet))->load();
+    }
     
     return settings;
 }
 
-void updateCoefficients(Coefficients& old, const Coefficients& replacements) {
-    *old = *replacements;
+OversamplingSettings getOversamplingSettings(juce::AudioProcessorValueTreeState& apvts) {
+    
+    OversamplingSettings settings;
+    
+    settings.order = static_cast<int>(apvts.getRawParameterValue("Oversampling")->load());
+    settings.linearPhase = apvts.getRawParameterValue("Oversampling Filter")->load() > 0.5f;
+    
+    return settings;
 }
 
-template<int Index,typename ChainType, typename CoefficientType>
-void update(ChainType& chain, const CoefficientType& coefficients) {
-    
-    updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
-    chain.template setBypassed<Index>(false);
+int getLinearPhaseKernelLength(juce::AudioProcessorValueTreeState& apvts) {
+    return LinearPhaseEngine::minKernelLength << static_cast<int>(apvts.getRawParameterValue("Linear Phase Length")->load());
 }
 
-template<typename ChainType, typename CoefficientType>
-void updateCutFilter(ChainType& leftLowCut,
-                     const CoefficientType& cutCoefficients,
-                     const Slope& lowCutSlope) {
+DynamicSettings getDynamicSettings(juce::AudioProcessorValueTreeState& apvts) {
     
-    leftLowCut.template setBypassed<0>(true);
-    leftLowCut.template setBypassed<1>(true);
-    leftLowCut.template setBypassed<2>(true);
-    leftLowCut.template setBypassed<3>(true);
+    DynamicSettings settings;
     
-    switch(lowCutSlope) {
-        case Slope_48:
-        {
-            update<3>(leftLowCut, cutCoefficients);
+    settings.thresholdInDecibels = apvts.getRawParameterValue("Peak Threshold")->load();
+    settings.ratio = apvts.getRawParameterValue("Peak Ratio")->load();
+    settings.attackInMilliseconds = apvts.getRawParameterValue("Peak Attack")->load();
+    settings.releaseInMilliseconds = apvts.getRawParameterValue("Peak Release")->load();
+    settings.externalSidechain = apvts.getRawParameterValue("Peak Detector")->load() > 0.5f;
+    
+    return settings;
+}
+
+void FilterPluginAudioProcessor::updateFilters() {
+    
+    if(auto* update = coefficientUpdater.pullUpdate()) {
+        
+        //designed from the settings before the running program was loaded
+        if(update->programGeneration < loadedProgramGeneration)
+            return;
+        
+        //mid/side changes what the lanes carry, so it restarts the chain like a new path
+        const auto midSide = update->channelMode == ChannelMode_MidSide;
+        const auto modeChanged = update->linearPhaseMode != linearPhaseActive
+                              || midSide != midSideActive;
+        //the double chain has a single structure, and linear phase runs neither
+        const auto structureChanged = update->stateVariable != stateVariableActive
+                                   && !isUsingDoublePrecision() && !update->linearPhaseMode;
+        
+        //each path starts from silence; the engine takes its first kernel without a crossfade
+        if(update->linearPhaseMode != linearPhaseActive) {
+            linearPhaseActive = update->linearPhaseMode;
+            linearPhaseEngine.reset();
         }
-        case Slope_36:
-        {
-            update<2>(leftLowCut, cutCoefficients);
+        
+        const auto wasStateVariable = stateVariableActive;
+        stateVariableActive = update->stateVariable;
+        setMidSide(midSide);
+        
+        //a detector switched on starts from silence
+        if(update->dynamics.isActive() && !dynamicPeak.getSettings().isActive())
+            dynamicPeak.reset();
+        
+        dynamicPeak.setParameters(update->dynamics, update->detectorBand, update->detectorDecimation);
+        targetSettings = update->settings;
+        targetCoefficients = update->coefficients;
+        targetIndependent = update->independent;
+        dynamicPeakDesigned = false;
+        automatedSettings = update->settings;
+        channelsLinked = update->channelMode == ChannelMode_Linked;
+        
+        const auto rateChanged = update->oversampling.order != activeOversampling.order
+                              || update->oversampling.linearPhase != activeOversampling.linearPhase;
+        
+        //a new path (or one that was idle, or none yet after prepareToPlay) leaves nothing to fade from:
+        //start the chain fresh at the target
+        if(modeChanged || (rateChanged && (linearPhaseActive || activeOversampling.order < 0))) {
+            setOversampling(update->oversampling);
+            presetFadeRemaining = 0;
+            rateFadeRemaining = 0;
+            
+            for(int set = 0; set < numChannelSets; set++)
+                chainSmoothers[(size_t) set].prepare(processingSampleRate, smoothingTime.load(), update->settings[(size_t) set]);
+            
+            resetChains();
+            setChainCoefficients(update->coefficients, update->independent);
+            return;
         }
-        case Slope_24:
-        {
-            update<1>(leftLowCut, cutCoefficients);
+        
+        //the new rate starts from silence at the target while the old one fades out
+        if(rateChanged) {
+            startRateFade(*update, wasStateVariable);
+            return;
         }
-        case Slope_12:
-        {
-            update<0>(leftLowCut, cutCoefficients);
+        
+        //the other structure starts from silence at the target while the one that ran so far fades
+        //out, as after a preset switch; a preset fade still running is cut short
+        if(structureChanged) {
+            for(int set = 0; set < numChannelSets; set++)
+                chainSmoothers[(size_t) set].prepare(processingSampleRate, smoothingTime.load(), update->settings[(size_t) set]);
+            
+            if(stateVariableActive)
+                stateVariableChain.reset();
+            else
+                channelChain.reset();
+            
+            setChainCoefficients(update->coefficients, update->independent);
+            
+            presetFadeLength = juce::jmax(1, juce::roundToInt(processingSampleRate * presetFadeTime));
+            presetFadeRemaining = presetFadeLength;
+            structureFade = true;
+            return;
+        }
+        
+        for(int set = 0; set < numChannelSets; set++)
+            chainSmoothers[(size_t) set].setTarget(update->settings[(size_t) set]);
+        
+        //nothing to ramp (e.g. only a slope changed): take the finished design as is
+        if(!isSmoothing()) {
+            setChainCoefficients(update->coefficients, update->independent);
         }
     }
 }
 
-void FilterPluginAudioProcessor::updateLowCutFilters(const ChainSettings &chainSettings) {
-    
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
-    
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
+CoefficientUpdater::CoefficientUpdater(juce::AudioProcessor& p, juce::AudioProcessorValueTreeState& s, LinearPhaseEngine& e, Profiler& profilerToUse)
+    : juce::Thread("Coefficient Updater"), processor(p), apvts(s), linearPhaseEngine(e), profiler(profilerToUse)
+{
+    for(auto* param : processor.getParameters())
+        param->addListener(this);
+}
+
+CoefficientUpdater::~CoefficientUpdater()
+{
+    for(auto* param : processor.getParameters())
+        param->removeListener(this);
     
-    updateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+    stopThread(1000);
 }
 
-void FilterPluginAudioProcessor::updateHighCutFilters(const ChainSettings &chainSettings) {
+void CoefficientUpdater::prepare(double newSampleRate, int newNumChannels) {
     
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+    stopThread(1000);
     
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+    sampleRate = newSampleRate;
+    numChannels = newNumChannels;
+    parametersChanged.store(false);
+    designCoefficients();
     
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    startThread();
+}
+
+void CoefficientUpdater::release() {
+    stopThread(1000);
 }
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate) {
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, chainSettings.peakFreq, chainSettings.peakQuality, juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+void CoefficientUpdater::markDirty() {
+    //hosts report automation on the audio thread, so no signal here: the thread polls the flag
+    parametersChanged.store(true);
 }
 
+void CoefficientUpdater::beginProgram() noexcept {
+    programGeneration.fetch_add(1, std::memory_order_release);
+    markDirty();
+}
 
-void FilterPluginAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings) {
-    
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
+const CoefficientUpdate* CoefficientUpdater::pullUpdate() noexcept {
+    return updates.pull() ? &updates.getReadBuffer() : nullptr;
+}
+
+void CoefficientUpdater::parameterValueChanged(int parameterIndex, float newValue) {
+    markDirty();
+}
+
+void CoefficientUpdater::run() {
     
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    while(!threadShouldExit()) {
+        if(parametersChanged.exchange(false))
+            designCoefficients();
+        
+        wait(pollInterval);
+    }
 }
 
-void FilterPluginAudioProcessor::updateFilters() {
+void CoefficientUpdater::designCoefficients() {
+    
+    Profiler::ScopedTimer timer(profiler, ProfileSection_Design);
+    auto& update = updates.getWriteBuffer();
+    //read before the parameters, so a program applied meanwhile makes this update stale
+    update.programGeneration = programGeneration.load(std::memory_order_acquire);
+    
+    update.linearPhaseMode = apvts.getRawParameterValue("Phase Mode")->load() > 0.5f;
+    update.stateVariable = apvts.getRawParameterValue("Filter Structure")->load() > 0.5f;
+    
+    //the linear-phase kernel is shared by every channel
+    update.channelMode = numChannels == 2 && !update.linearPhaseMode
+                       ? static_cast<ChannelMode>(apvts.getRawParameterValue("Channel Mode")->load())
+                       : ChannelMode_Linked;
+    
+    update.settings[0] = getChainSettings(apvts);
+    update.settings[1] = update.channelMode == ChannelMode_Linked ? update.settings[0] : getChainSettings(apvts, 1);
+    update.independent = !(update.settings[1] == update.settings[0]);
+    
+    //the FIR needs no oversampling, it follows the analog prototypes up to Nyquist
+    if(update.linearPhaseMode) {
+        update.oversampling = {};
+        linearPhaseEngine.designKernel(update.settings[0], sampleRate, getLinearPhaseKernelLength(apvts));
+    }
+    else {
+        update.oversampling = getOversamplingSettings(apvts);
+    }
     
-    auto chainSettings = getChainSettings(apvts);
+    //a second set that matches the first is not designed again
+    for(int set = 0; set < (update.independent ? numChannelSets : 1); set++)
+        coefficientCache->makeChainCoefficients(update.coefficients[(size_t) set], update.settings[(size_t) set], sampleRate * (1 << update.oversampling.order));
     
-    updateLowCutFilters(chainSettings);
-    updateHighCutFilters(chainSettings);
-    updatePeakFilter(chainSettings);
+    update.dynamics = getDynamicSettings(apvts);
+    update.detectorDecimation = DynamicPeak::getDecimation(sampleRate, update.settings[0].peakFreq, update.settings[0].peakQuality);
+    BiquadDesign::makeBandPass(update.detectorBand, sampleRate / update.detectorDecimation, update.settings[0].peakFreq, update.settings[0].peakQuality);
+    
+    updates.publish();
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout FilterPluginAudioProcessor::createParameterLayout() {
     
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Freq", "LowCut Freq", juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f), 20.0f));
+    auto chainParameters = createChainParameters(0);
+    layout.add(chainParameters.begin(), chainParameters.end());
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Freq", "HighCut Freq", juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f), 20000.0f));
+    //dynamic peak: off while the ratio is 1
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Threshold", "Peak Threshold", juce::NormalisableRange<float>(-60.0f, 0.0f, 0.5f, 1.0f), 0.0f));
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Freq", "Peak Freq", juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f), 750.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Ratio", "Peak Ratio", juce::NormalisableRange<float>(1.0f, 20.0f, 0.1f, 0.4f), 1.0f));
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Gain", "Peak Gain", juce::NormalisableRange<float>(-24.0f, 24.0f, 0.5f, 1.0f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Attack", "Peak Attack", juce::NormalisableRange<float>(0.1f, 200.0f, 0.1f, 0.4f), 10.0f));
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Quality", "Peak Quality", juce::NormalisableRange<float>(0.1f, 10.0f, 0.05f, 1.0f), 1.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Release", "Peak Release", juce::NormalisableRange<float>(5.0f, 2000.0f, 1.0f, 0.4f), 150.0f));
     
-    juce::StringArray stringArray;
-    for(int i = 0; i < 4; i++){
-        juce::String str;
-        str << (12 + i * 12);
-        str << " db/Oct";
-        stringArray.add(str);
-    }
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Peak Detector", "Peak Detector", juce::StringArray { "Band", "Sidechain" }, 0));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling", juce::StringArray { "Off", "2x", "4x", "8x" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling Filter", "Oversampling Filter", juce::StringArray { "IIR (low latency)", "FIR (linear phase)" }, 0));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Filter Structure", "Filter Structure", juce::StringArray { "Direct form", "State variable" }, 0));
+    
+    //peak and cut designs: bilinear (cramped towards Nyquist) or matched to the analog magnitude
+    layout.add(createFilterDesignParameter());
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Phase Mode", "Phase Mode", juce::StringArray { "Minimum phase", "Linear phase" }, 0));
+    
+    juce::StringArray kernelLengths;
+    for(int length = LinearPhaseEngine::minKernelLength; length <= LinearPhaseEngine::maxKernelLength; length *= 2)
+        kernelLengths.add(juce::String(length) + " taps");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Linear Phase Length", "Linear Phase Length", kernelLengths, 1));
     
-    layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope", stringArray, 0));
-    layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", stringArray, 0));
+    //stereo only: the "Channel 2" set filters the right or side channel
+    layout.add(createChannelModeParameter());
+    chainParameters = createChainParameters(1);
+    layout.add(chainParameters.begin(), chainParameters.end());
 
     return layout;
 }
@@ -1,59 +1,110 @@
 #pragma once
 #include <JuceHeader.h>
+#include "AutomationEvents.h"
+#include "ChainSmoother.h"
+#include "ChannelWorkers.h"
+#include "CoefficientCache.h"
+#include "CoefficientTable.h"
+#include "DynamicPeak.h"
+#include "FilterChain.h"
+#include "LinearPhaseEngine.h"
+#include "OversamplingStage.h"
+#include "PluginState.h"
+#include "PresetBank.h"
+#include "Profiler.h"
+#include "RealtimeSafety.h"
+#include "SIMDChain.h"
+#include "SpectrumAnalyser.h"
+#include "TripleBuffer.h"
 
-using Filter = juce::dsp::IIR::Filter<float>;
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts, int channelSet = 0);
 
-//dla każdego cutoff
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+OversamplingSettings getOversamplingSettings(juce::AudioProcessorValueTreeState& apvts);
+int getLinearPhaseKernelLength(juce::AudioProcessorValueTreeState& apvts);
+DynamicSettings getDynamicSettings(juce::AudioProcessorValueTreeState& apvts);
 
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
-
-enum ChainPositions {
-    LowCut,
-    Peak,
-    HighCut
-}; 
-
-enum Slope {
-    Slope_12,
-    Slope_24,
-    Slope_36,
-    Slope_48
+//settings together with the coefficients designed from them
+struct CoefficientUpdate {
+    //left/mid and right/side; linked (and linear-phase) processing uses the first set for both
+    std::array<ChainSettings, numChannelSets> settings;
+    ChannelMode channelMode { ChannelMode_Linked };
+    //the second set differs from the first; only then is coefficients[1] designed
+    bool independent { false };
+    OversamplingSettings oversampling;
+    //the linear-phase engine replaces the IIR chain, its kernel is published before this update
+    bool linearPhaseMode { false };
+    //float path only: state variable sections instead of transposed direct form II
+    bool stateVariable { false };
+    //designed for the oversampled rate
+    std::array<ChainCoefficients, numChannelSets> coefficients;
+    //dynamic peak band; its detector runs at the host rate / detectorDecimation in every IIR mode
+    DynamicSettings dynamics;
+    BiquadCoefficients detectorBand;
+    int detectorDecimation { 1 };
+    //program changes before the design started; an update older than the loaded program is stale
+    int programGeneration { 0 };
 };
 
-struct ChainSettings {
-    float peakGainInDecibels {0}, peakFreq {0}, peakQuality {1.0f};
-    float lowCutFreq {0}, highCutFreq {0};
-    Slope lowCutSlope { Slope::Slope_12 }, highCutSlope { Slope::Slope_12 };
-};
+//Designs coefficients (and linear-phase kernels) on a background thread whenever a
+//parameter changes and hands them to the audio thread through a TripleBuffer.
+class CoefficientUpdater : private juce::Thread,
+                           private juce::AudioProcessorParameter::Listener
+{
+public:
+    CoefficientUpdater(juce::AudioProcessor& processor, juce::AudioProcessorValueTreeState& apvts, LinearPhaseEngine& linearPhaseEngine, Profiler& profiler);
+    ~CoefficientUpdater() override;
 
+    //message thread, audio stopped; channel modes apply to stereo buses only
+    void prepare(double sampleRate, int numChannels);
+    void release();
+    //any thread, lock-free: the next poll designs new coefficients
+    void markDirty();
+    //message thread, once a program's parameters are applied: updates from before are stale
+    void beginProgram() noexcept;
+    int getProgramGeneration() const noexcept { return programGeneration.load(std::memory_order_acquire); }
 
-using Coefficients = Filter::CoefficientsPtr;
+    //audio thread: newest coefficients, or nullptr when nothing has changed
+    const CoefficientUpdate* pullUpdate() noexcept;
 
-void updateCoefficients(Coefficients& old, const Coefficients& replacements);
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
+private:
+    void run() override;
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override { }
+    void designCoefficients();
+
+    juce::AudioProcessor& processor;
+    juce::AudioProcessorValueTreeState& apvts;
+    LinearPhaseEngine& linearPhaseEngine;
+    Profiler& profiler;
 
+    //shared with every other instance in the process
+    juce::SharedResourcePointer<CoefficientCache> coefficientCache;
+    TripleBuffer<CoefficientUpdate> updates;
+    std::atomic<bool> parametersChanged { true };
+    std::atomic<int> programGeneration { 0 };
+    //milliseconds between checks of parametersChanged, the longest a change waits before its design starts
+    static constexpr int pollInterval { 5 };
+    double sampleRate { 44100.0 };
+    int numChannels { 2 };
+};
 
-inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate) {
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
-                                                                                      sampleRate,
-                                                                                      (chainSettings.lowCutSlope + 1) * 2);
-}
+class FilterPluginAudioProcessor;
 
-inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate) {
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
-                                                                                      sampleRate,
-                                                                                      (chainSettings.highCutSlope + 1) * 2);
-}
+//setLatencySamples notifies the host, which must not happen on the audio thread: the audio
+//thread only stores the latency, and one message thread timer for every instance in the process
+//(through a SharedResourcePointer) hands changes to the hosts
+class LatencyNotifier : private juce::Timer
+{
+public:
+    //message thread
+    void add(FilterPluginAudioProcessor* processor);
+    void remove(FilterPluginAudioProcessor* processor);
 
-template<typename ChainType, typename CoefficientType>
-void updateCutFilter(ChainType& leftLowCut,
-                     const CoefficientType& cutCoefficients,
-                     const Slope& lowCutSlope);
+private:
+    std::vector<FilterPluginAudioProcessor*> processors;
 
-template<int Index,typename ChainType, typename CoefficientType>
-void update(ChainType& chain, const CoefficientType& cutCoefficients);
+    void timerCallback() override;
+};
 
 class FilterPluginAudioProcessor  : public juce::AudioProcessor
 {
@@ -68,6 +119,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
     const juce::String getName() const override;
@@ -84,16 +137,180 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
+    //length of the parameter ramps, takes effect on the next prepareToPlay
+    void setSmoothingTime(float seconds) noexcept;
+    //how many samples run between coefficient redesigns while a ramp is active
+    void setCoefficientUpdateInterval(int numSamples) noexcept;
+    //audio thread, before processBlock: a change of a chain parameter at sampleOffset into the next block,
+    //for code hosting the processor directly that has timestamped automation; the plugin wrappers
+    //report none, so their changes all start at the beginning of a block
+    void addParameterEvent(int parameterIndex, float normalisedValue, int sampleOffset) noexcept;
+    //resolution of the lookup table the ramps are redesigned from, 0 designs directly;
+    //takes effect on the next prepareToPlay
+    void setCoefficientTableResolution(int segmentsPerOctave) noexcept;
+    //worker threads the chain's channel groups are spread over on large buses, 0 (the default)
+    //processes serially; the pool is shared by every instance and runs the largest number any of
+    //them asks for, but no more than there are groups and spare cores. Takes effect on the next prepareToPlay
+    void setChannelWorkers(int numWorkers) noexcept;
+    //pieces of a block shorter than this (at the processing rate) run serially
+    void setParallelThreshold(int numSamples) noexcept;
+    
+   #if FILTERPLUGIN_AUDIO_WORKGROUPS
+    void audioWorkgroupContextChanged(const juce::AudioWorkgroup& workgroup) override;
+   #endif
+    
+    //message thread: reports a latency the audio thread has changed to the host
+    void updateHostLatency();
+    
+    SpectrumAnalyser& getAnalyser() noexcept { return analyser; }
+    //timings of this instance; empty unless built with FILTERPLUGIN_PROFILING
+    Profiler& getProfiler() noexcept { return profiler; }
+    
+    //rate the filters are designed for: host rate times the selected oversampling factor,
+    //host rate in linear-phase mode
+    double getFilterSampleRate();
+    
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
 
 private:
-    MonoChain leftChain, rightChain;
+    //every channel of the main bus runs in the lanes of one SIMD chain, with one coefficient set
+    //or, in the left/right and mid/side modes, one per side;
+    //there is one chain per float topology and one for double, only the active one is fed
+    SIMDChain channelChain;
+    SIMDStateVariableChain stateVariableChain;
+    SIMDChainDouble doubleChain;
+    bool stateVariableActive { false };
+    
+    //a preset switch swaps the running chain in here and fades from it to the preset's design;
+    //a Filter Structure switch fades from the other float chain instead (structureFade)
+    SIMDChain fadeChannelChain;
+    SIMDStateVariableChain fadeStateVariableChain;
+    SIMDChainDouble fadeDoubleChain;
+    //the outgoing chain runs on a copy of the input, sized for the largest oversampled block
+    juce::AudioBuffer<float> fadeBuffer;
+    juce::AudioBuffer<double> doubleFadeBuffer;
+    int presetFadeRemaining { 0 }, presetFadeLength { 0 };
+    bool structureFade { false };
+    
+    //an oversampling switch swaps the running chain into the fade chain too: with the outgoing
+    //oversampler it goes on filtering a copy of the input (a block at the host rate) and is mixed
+    //out at the host rate over presetFadeTime, latency aligned by the OversamplingStage
+    juce::AudioBuffer<float> rateFadeBuffer;
+    juce::AudioBuffer<double> doubleRateFadeBuffer;
+    int rateFadeRemaining { 0 }, rateFadeLength { 0 };
+    bool rateFadeStateVariable { false };
+    static constexpr double presetFadeTime { 0.02 };
+    
+    PresetBank presetBank;
+    int currentProgram { 0 };
+    //set by setCurrentProgram, taken by the audio thread at the start of the next block
+    std::atomic<int> pendingProgram { -1 };
+    //the updater's program generation when the running program was loaded
+    int loadedProgramGeneration { 0 };
+    
+    //every parameter by the hash of its id, as stored in the binary state; sorted by hash
+    std::vector<std::pair<juce::uint32, juce::RangedAudioParameter*>> parametersByHash;
+    LinearPhaseEngine linearPhaseEngine;
+    Profiler profiler;
+    CoefficientUpdater coefficientUpdater { *this, apvts, linearPhaseEngine, profiler };
+    bool linearPhaseActive { false };
+    
+    //one per channel set; the second follows the first while the channels are linked
+    std::array<ChainSmoother, numChannelSets> chainSmoothers;
+    std::array<ChainCoefficients, numChannelSets> smoothedCoefficients;
+    bool midSideActive { false };
+    
+    //last design from the updater, the base the dynamic peak gain is added to
+    std::array<ChainSettings, numChannelSets> targetSettings;
+    std::array<ChainCoefficients, numChannelSets> targetCoefficients;
+    bool targetIndependent { false };
+    
+    //the updater's settings with the automation events of the blocks since applied, the ramps' targets
+    AutomationEvents automationEvents { *this };
+    std::array<ChainSettings, numChannelSets> automatedSettings;
+    bool channelsLinked { true };
+    //an event splits the block where it falls, but no piece is shorter than this (at the host rate)
+    static constexpr int minAutomationSegmentLength { 16 };
+    DynamicPeak dynamicPeak;
+    //samples of the current block the chain has run, at the processing rate
+    int chainPosition { 0 };
+    //dynamic gain (dB) the chain was last designed for; smaller moves keep the design
+    float designedGainChange { 0 };
+    bool dynamicPeakDesigned { false };
+    static constexpr float dynamicGainResolution { 0.01f };
+    //a moving dynamic gain is redesigned once it is dynamicGainStep dB away, but not more often
+    //than every dynamicSegmentLength samples (at the host rate)
+    static constexpr float dynamicGainStep { 0.25f };
+    static constexpr int dynamicSegmentLength { 4 };
+    double currentSampleRate { 44100.0 };
+    double processingSampleRate { 44100.0 };
+    
+    //only the stage for the precision in use is prepared
+    OversamplingStage<float> oversampling;
+    OversamplingStage<double> doubleOversampling;
+    OversamplingSettings activeOversampling;
+    
+    //set by the audio thread, handed to the host from the message thread
+    std::atomic<int> latencySamples { 0 };
+    
+    SpectrumAnalyser analyser;
+    
+    std::atomic<float> smoothingTime { 0.05f };
+    std::atomic<int> coefficientUpdateInterval { 32 };
+    
+    //the redesigns on the audio thread (ramps and the dynamic peak) look up their trigonometric
+    //and gain terms here; the updater thread keeps designing directly
+    CoefficientTable coefficientTable;
+    std::atomic<int> coefficientTableResolution { CoefficientTable::defaultSegmentsPerOctave };
+    
+    //one task per SIMD group of channels; the audio thread takes tasks too.
+    //Shared with every other instance in the process
+    juce::SharedResourcePointer<ChannelWorkers> channelWorkers;
+    std::atomic<int> maxChannelWorkers { 0 };
+    std::atomic<int> parallelThreshold { ChannelWorkers::defaultMinSamples };
     
-    void updatePeakFilter(const ChainSettings& chainSettings);
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
     void updateFilters();
+    //keepOutgoing leaves the previous oversampler running for a rate fade
+    void setOversampling(const OversamplingSettings& settings, bool keepOutgoing = false) noexcept;
+    //wasStateVariable: the structure the running float chain has
+    void startRateFade(const CoefficientUpdate& update, bool wasStateVariable) noexcept;
+    int getProcessingLatency() const noexcept;
+    
+    template<typename SampleType> void processSamples(juce::AudioBuffer<SampleType>& buffer) noexcept;
+    template<typename SampleType> void analyseDynamics(juce::AudioBuffer<SampleType>& buffer, int numChannels) noexcept;
+    template<typename SampleType> void processChains(SampleType* const* channels, int numChannels, int numSamples) noexcept;
+    //runs the chain from start to end, which no automation event falls inside; returns end
+    template<typename SampleType> int processChainSegment(SampleType* const* channels, int numChannels, int start, int end, int updateInterval, bool dynamic) noexcept;
+    float getDynamicGainChange(int startSample) const noexcept;
+    template<typename SampleType> OversamplingStage<SampleType>& getOversamplingStage() noexcept;
+    template<typename SampleType> juce::AudioBuffer<SampleType>& getRateFadeBuffer() noexcept;
+    //the old rate's path on a copy of the first numSamples, then mixed out of the new one's output
+    template<typename SampleType> void processOutgoingRate(const juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) noexcept;
+    template<typename SampleType> void mixOutgoingRate(juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) noexcept;
+    void runOutgoingChain(float* const* channels, int numChannels, int numSamples) noexcept;
+    void runOutgoingChain(double* const* channels, int numChannels, int numSamples) noexcept;
+    
+    bool isSmoothing() const noexcept;
+    
+    //the chain for the current precision and topology; the second set is used only when independent
+    void setChainCoefficients(const std::array<ChainCoefficients, numChannelSets>& coefficients, bool independent) noexcept;
+    void setMidSide(bool shouldUseMidSide) noexcept;
+    bool isChainFlat() const noexcept;
+    void processChain(float* const* channels, int numChannels, int startSample, int numSamples) noexcept;
+    void processChain(double* const* channels, int numChannels, int startSample, int numSamples) noexcept;
+    //the chain's groups on the workers when there are several and the piece is long enough
+    template<typename Chain, typename SampleType>
+    void runChain(Chain& chain, SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept;
+    void resetChains() noexcept;
+    
+    //audio thread: switches to a pending preset's precomputed design and starts the fade to it
+    void loadPendingProgram() noexcept;
+    template<typename Chain, typename FadeChain, typename SampleType>
+    void processPresetFade(Chain& chain, FadeChain& fadeChain, juce::AudioBuffer<SampleType>& buffer,
+                           SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept;
+    
+    juce::SharedResourcePointer<LatencyNotifier> latencyNotifier;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FilterPluginAudioProcessor)
 };
@@ -0,0 +1,283 @@
+#include "PluginState.h"
+
+ChainParameter ChainParameter::fromID(const juce::String& id) {
+    
+    const auto prefix = getChannelParameterID(1, {});
+    
+    ChainParameter parameter;
+    parameter.channelSet = id.startsWith(prefix) ? 1 : 0;
+    
+    //the rest of the id is the same for both sets
+    const auto name = parameter.channelSet > 0 ? id.substring(prefix.length()) : id;
+    
+    if(name == "LowCut Freq")
+        parameter.field = LowCutFreq;
+    else if(name == "HighCut Freq")
+        parameter.field = HighCutFreq;
+    else if(name == "Peak Freq")
+        parameter.field = PeakFreq;
+    else if(name == "Peak Gain")
+        parameter.field = PeakGain;
+    else if(name == "Peak Quality")
+        parameter.field = PeakQuality;
+    else if(name == "LowCut Slope")
+        parameter.field = LowCutSlope;
+    else if(name == "HighCut Slope")
+        parameter.field = HighCutSlope;
+    else if(name.startsWith("Band ")) {
+        parameter.band = name.fromFirstOccurrenceOf("Band ", false, false).getIntValue() - 1;
+        const auto bandName = name.fromLastOccurrenceOf(" ", false, false);
+        
+        if(!juce::isPositiveAndBelow(parameter.band, maxBands))
+            return {};
+        
+        if(bandName == "Type")
+            parameter.field = BandType;
+        else if(bandName == "Freq")
+            parameter.field = BandFreq;
+        else if(bandName == "Gain")
+            parameter.field = BandGain;
+        else if(bandName == "Quality")
+            parameter.field = BandQuality;
+    }
+    
+    return parameter;
+}
+
+void ChainParameter::apply(ChainSettings& settings, float value) const noexcept {
+    
+    auto& bandSettings = settings.bands[(size_t) band];
+    
+    switch(field) {
+        case LowCutFreq: settings.lowCutFreq = value; break;
+        case HighCutFreq: settings.highCutFreq = value; break;
+        case PeakFreq: settings.peakFreq = value; break;
+        case PeakGain: settings.peakGainInDecibels = value; break;
+        case PeakQuality: settings.peakQuality = value; break;
+        case LowCutSlope: settings.lowCutSlope = static_cast<Slope>(juce::jlimit(0, 3, juce::roundToInt(value))); break;
+        case HighCutSlope: settings.highCutSlope = static_cast<Slope>(juce::jlimit(0, 3, juce::roundToInt(value))); break;
+        case BandType: bandSettings.type = static_cast<::BandType>(juce::jlimit(0, (int) BandType_BandPass, juce::roundToInt(value))); break;
+        case BandFreq: bandSettings.freq = value; break;
+        case BandGain: bandSettings.gainInDecibels = value; break;
+        case BandQuality: bandSettings.quality = value; break;
+        case None: break;
+    }
+}
+
+ChainSettings getChainSettings(const juce::ValueTree& state, int channelSet) {
+    
+    //parameters missing from the state keep their defaults
+    ChainSettings settings;
+    settings.designMode = static_cast<DesignMode>(createFilterDesignParameter()->getIndex());
+    
+    for(const auto& parameter : createChainParameters(channelSet))
+        ChainParameter::fromID(parameter->paramID).apply(settings, parameter->convertFrom0to1(parameter->getDefaultValue()));
+    
+    //APVTS keeps one PARAM child per parameter, holding the denormalised value
+    for(const auto& param : state) {
+        const auto id = param.getProperty("id").toString();
+        
+        //shared by both sets
+        if(id == "Filter Design") {
+            settings.designMode = static_cast<DesignMode>(juce::jlimit(0, numDesignModes - 1, juce::roundToInt(static_cast<float>(param.getProperty("value")))));
+            continue;
+        }
+        
+        const auto parameter = ChainParameter::fromID(id);
+        
+        //only the requested set
+        if(parameter.channelSet == channelSet)
+            parameter.apply(settings, static_cast<float>(param.getProperty("value")));
+    }
+    
+    return settings;
+}
+
+ChannelMode getChannelMode(const juce::ValueTree& state) {
+    
+    for(const auto& param : state)
+        if(param.getProperty("id").toString() == "Channel Mode")
+            return static_cast<ChannelMode>(juce::jlimit(0, (int) ChannelMode_MidSide, juce::roundToInt(static_cast<float>(param.getProperty("value")))));
+    
+    return static_cast<ChannelMode>(createChannelModeParameter()->getIndex());
+}
+
+ProcessingSettings getProcessingSettings(const juce::ValueTree& state) {
+    
+    ProcessingSettings processing;
+    
+    for(const auto& param : state) {
+        const auto id = param.getProperty("id").toString();
+        const auto value = static_cast<float>(param.getProperty("value"));
+        
+        if(id == "Filter Structure")
+            processing.stateVariable = value > 0.5f;
+        else if(id == "Oversampling")
+            processing.oversamplingOrder = juce::jlimit(0, 3, juce::roundToInt(value));
+        else if(id == "Phase Mode")
+            processing.linearPhase = value > 0.5f;
+        else if(id == "Peak Ratio")
+            processing.dynamicPeak = value > 1.0f;
+    }
+    
+    return processing;
+}
+
+juce::StringArray getProcessingParameterIDs() {
+    return { "Filter Structure", "Oversampling", "Phase Mode", "Peak Ratio" };
+}
+
+juce::String getChannelParameterID(int channelSet, const juce::String& name) {
+    return channelSet > 0 ? "Channel " + juce::String(channelSet + 1) + " " + name : name;
+}
+
+juce::String getBandParameterID(int band, const juce::String& name, int channelSet) {
+    return getChannelParameterID(channelSet, "Band " + juce::String(band + 1) + " " + name);
+}
+
+juce::StringArray getChainParameterIDs() {
+    
+    juce::StringArray ids { "Channel Mode", "Filter Design" };
+    
+    for(int set = 0; set < numChannelSets; set++) {
+        for(auto* name : { "LowCut Freq", "HighCut Freq", "Peak Freq", "Peak Gain", "Peak Quality", "LowCut Slope", "HighCut Slope" })
+            ids.add(getChannelParameterID(set, name));
+        
+        for(int k = 0; k < maxBands; k++)
+            for(auto* name : { "Type", "Freq", "Gain", "Quality" })
+                ids.add(getBandParameterID(k, name, set));
+    }
+    
+    return ids;
+}
+
+std::vector<std::unique_ptr<juce::RangedAudioParameter>> createChainParameters(int channelSet) {
+    
+    std::vector<std::unique_ptr<juce::RangedAudioParameter>> parameters;
+    
+    auto addFloat = [&](const juce::String& id, juce::NormalisableRange<float> range, float defaultValue) {
+        parameters.push_back(std::make_unique<juce::AudioParameterFloat>(id, id, range, defaultValue));
+    };
+    
+    auto addChoice = [&](const juce::String& id, const juce::StringArray& choices) {
+        parameters.push_back(std::make_unique<juce::AudioParameterChoice>(id, id, choices, 0));
+    };
+    
+    addFloat(getChannelParameterID(channelSet, "LowCut Freq"), juce::NormalisableRange<float>(minCutFrequency, maxCutFrequency, 1.0f, 0.25f), minCutFrequency);
+    
+    addFloat(getChannelParameterID(channelSet, "HighCut Freq"), juce::NormalisableRange<float>(minCutFrequency, maxCutFrequency, 1.0f, 0.25f), maxCutFrequency);
+    
+    addFloat(getChannelParameterID(channelSet, "Peak Freq"), juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f), 750.0f);
+    
+    addFloat(getChannelParameterID(channelSet, "Peak Gain"), juce::NormalisableRange<float>(-24.0f, 24.0f, 0.5f, 1.0f), 0.0f);
+    
+    addFloat(getChannelParameterID(channelSet, "Peak Quality"), juce::NormalisableRange<float>(0.1f, 10.0f, 0.05f, 1.0f), 1.0f);
+    
+    juce::StringArray stringArray;
+    for(int i = 0; i < 4; i++){
+        juce::String str;
+        str << (12 + i * 12);
+        str << " db/Oct";
+        stringArray.add(str);
+    }
+    
+    addChoice(getChannelParameterID(channelSet, "LowCut Slope"), stringArray);
+    addChoice(getChannelParameterID(channelSet, "HighCut Slope"), stringArray);
+    
+    //parametric bands, all off by default
+    for(int k = 0; k < maxBands; k++) {
+        addChoice(getBandParameterID(k, "Type", channelSet), juce::StringArray { "Off", "Peak", "Low Shelf", "High Shelf", "Notch", "Band Pass" });
+        addFloat(getBandParameterID(k, "Freq", channelSet), juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f), getDefaultBandFrequency(k));
+        addFloat(getBandParameterID(k, "Gain", channelSet), juce::NormalisableRange<float>(-24.0f, 24.0f, 0.5f, 1.0f), 0.0f);
+        addFloat(getBandParameterID(k, "Quality", channelSet), juce::NormalisableRange<float>(0.1f, 10.0f, 0.05f, 1.0f), 1.0f);
+    }
+    
+    return parameters;
+}
+
+std::unique_ptr<juce::AudioParameterChoice> createFilterDesignParameter() {
+    return std::make_unique<juce::AudioParameterChoice>("Filter Design", "Filter Design", juce::StringArray { "Bilinear", "Matched" }, 0);
+}
+
+std::unique_ptr<juce::AudioParameterChoice> createChannelModeParameter() {
+    return std::make_unique<juce::AudioParameterChoice>("Channel Mode", "Channel Mode", juce::StringArray { "Linked", "Left/Right", "Mid/Side" }, 0);
+}
+
+juce::uint32 getParameterIDHash(const juce::String& id) {
+    
+    juce::uint32 hash = 2166136261u;
+    
+    for(auto* c = id.toRawUTF8(); *c != 0; c++) {
+        hash ^= (juce::uint8) *c;
+        hash *= 16777619u;
+    }
+    
+    return hash;
+}
+
+bool isBinaryState(const void* data, int sizeInBytes) noexcept {
+    return data != nullptr && sizeInBytes >= binaryStateHeaderSize
+        && juce::ByteOrder::littleEndianInt(data) == binaryStateMagic;
+}
+
+bool readBinaryState(const void* data, int sizeInBytes, std::vector<std::pair<juce::uint32, float>>& values) {
+    
+    if(!isBinaryState(data, sizeInBytes))
+        return false;
+    
+    const auto* bytes = static_cast<const char*>(data);
+    const auto numValues = (int) juce::ByteOrder::littleEndianShort(bytes + 6);
+    
+    if(juce::ByteOrder::littleEndianShort(bytes + 4) < 1 || sizeInBytes < binaryStateHeaderSize + numValues * binaryStateValueSize)
+        return false;
+    
+    values.resize((size_t) numValues);
+    
+    for(int i = 0; i < numValues; i++) {
+        const auto* entry = bytes + binaryStateHeaderSize + i * binaryStateValueSize;
+        const auto bits = juce::ByteOrder::littleEndianInt(entry + 4);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        values[(size_t) i] = { juce::ByteOrder::littleEndianInt(entry), value };
+    }
+    
+    return true;
+}
+
+juce::ValueTree readChainState(const void* data, int sizeInBytes) {
+    
+    std::vector<std::pair<juce::uint32, float>> values;
+    
+    if(!readBinaryState(data, sizeInBytes, values))
+        return juce::ValueTree::readFromData(data, (size_t) sizeInBytes);
+    
+    //only the hashes are stored, so the ids are matched against the known ones
+    juce::ValueTree tree("Parameters");
+    auto ids = getChainParameterIDs();
+    ids.addArray(getProcessingParameterIDs());
+    
+    for(const auto& id : ids) {
+        const auto hash = getParameterIDHash(id);
+        const auto value = std::find_if(values.begin(), values.end(), [hash](const auto& entry) { return entry.first == hash; });
+        
+        if(value != values.end())
+            tree.appendChild(juce::ValueTree("PARAM", { { "id", id }, { "value", value->second } }), nullptr);
+    }
+    
+    return tree;
+}
+
+bool loadChainSettings(const void* data, int sizeInBytes, std::array<ChainSettings, numChannelSets>& settings, ChannelMode& channelMode, ProcessingSettings& processing) {
+    
+    auto tree = readChainState(data, sizeInBytes);
+    
+    if(!tree.isValid())
+        return false;
+    
+    for(int set = 0; set < numChannelSets; set++)
+        settings[(size_t) set] = getChainSettings(tree, set);
+    
+    channelMode = getChannelMode(tree);
+    processing = getProcessingSettings(tree);
+    return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <JuceHeader.h>
+#include "FilterChain.h"
+
+//Reads the parameters out of a state written by FilterPluginAudioProcessor::getStateInformation
+//without needing a processor instance, e.g. for offline rendering.
+//Parameters missing from the state keep the defaults from createParameterLayout.
+//channelSet 1 reads the right/side parameters.
+ChainSettings getChainSettings(const juce::ValueTree& state, int channelSet = 0);
+ChannelMode getChannelMode(const juce::ValueTree& state);
+
+//A chain parameter resolved from its id once, so values can be applied to ChainSettings
+//without string handling (e.g. on the audio thread). Ids that are not chain parameters give None.
+struct ChainParameter {
+    enum Field {
+        None,
+        LowCutFreq, HighCutFreq, PeakFreq, PeakGain, PeakQuality, LowCutSlope, HighCutSlope,
+        BandType, BandFreq, BandGain, BandQuality
+    };
+    
+    Field field { None };
+    int channelSet { 0 };
+    int band { 0 };
+    
+    static ChainParameter fromID(const juce::String& id);
+    //value is denormalised, choices are indices
+    void apply(ChainSettings& settings, float value) const noexcept;
+};
+
+//the first channel set keeps the plain ids, the second prefixes them, e.g. "Channel 2 Peak Gain"
+juce::String getChannelParameterID(int channelSet, const juce::String& name);
+
+//parameter ids of the parametric bands, e.g. "Band 3 Freq" for band index 2
+juce::String getBandParameterID(int band, const juce::String& name, int channelSet = 0);
+
+//every id getChainSettings and getChannelMode read, for both channel sets
+juce::StringArray getChainParameterIDs();
+
+//The processing around the chain a state asks for. Parameters missing from the state are off,
+//as their defaults are.
+struct ProcessingSettings {
+    bool stateVariable { false };
+    int oversamplingOrder { 0 };
+    bool linearPhase { false };
+    bool dynamicPeak { false };
+};
+
+ProcessingSettings getProcessingSettings(const juce::ValueTree& state);
+//the ids getProcessingSettings reads
+juce::StringArray getProcessingParameterIDs();
+
+//The parameters getChainSettings and getChannelMode read, as createParameterLayout adds them:
+//the cuts, peak and bands of one channel set, and the two shared by both sets. Their defaults
+//are what a state without them is read with.
+std::vector<std::unique_ptr<juce::RangedAudioParameter>> createChainParameters(int channelSet);
+std::unique_ptr<juce::AudioParameterChoice> createFilterDesignParameter();
+std::unique_ptr<juce::AudioParameterChoice> createChannelModeParameter();
+
+//Compact binary state, written by getStateInformation since version 1:
+//  uint32 magic "FPst", uint16 version, uint16 number of values,
+//  then per parameter uint32 FNV-1a hash of its id and float32 denormalised value, all little endian.
+//Later versions may append data after the values, which older readers skip.
+//Older states are the APVTS ValueTree written with writeToStream and are still read.
+constexpr juce::uint32 binaryStateMagic = 0x74735046;
+constexpr int binaryStateVersion = 1;
+constexpr int binaryStateHeaderSize = 8, binaryStateValueSize = 8;
+
+juce::uint32 getParameterIDHash(const juce::String& id);
+bool isBinaryState(const void* data, int sizeInBytes) noexcept;
+//the (id hash, value) pairs of a binary state, false if it is not one
+bool readBinaryState(const void* data, int sizeInBytes, std::vector<std::pair<juce::uint32, float>>& values);
+
+//either format as an APVTS-style tree holding the chain and processing parameters, for reading without a processor
+juce::ValueTree readChainState(const void* data, int sizeInBytes);
+bool loadChainSettings(const void* data, int sizeInBytes, std::array<ChainSettings, numChannelSets>& settings, ChannelMode& channelMode, ProcessingSettings& processing);
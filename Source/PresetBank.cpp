@@ -0,0 +1,84 @@
+#include "PresetBank.h"
+#include "PluginState.h"
+
+PresetBank::PresetBank() {
+    
+    //denormalised parameter values; slopes and band types are choice indices
+    presets = {
+        { "Default", {} },
+        { "Rumble Filter", { { "LowCut Freq", 80.0f }, { "LowCut Slope", 3.0f } } },
+        { "Vocal Presence", { { "LowCut Freq", 100.0f }, { "LowCut Slope", 1.0f },
+                              { "Peak Freq", 3000.0f }, { "Peak Gain", 3.0f }, { "Peak Quality", 0.7f },
+                              { "Band 1 Type", (float) BandType_Peak }, { "Band 1 Freq", 300.0f }, { "Band 1 Gain", -2.0f }, { "Band 1 Quality", 1.5f },
+                              { "Band 2 Type", (float) BandType_HighShelf }, { "Band 2 Freq", 10000.0f }, { "Band 2 Gain", 2.0f } } },
+        { "Warm Bass", { { "HighCut Freq", 12000.0f },
+                         { "Peak Freq", 2500.0f }, { "Peak Gain", -2.0f },
+                         { "Band 1 Type", (float) BandType_LowShelf }, { "Band 1 Freq", 120.0f }, { "Band 1 Gain", 4.0f } } },
+        { "Telephone", { { "LowCut Freq", 300.0f }, { "LowCut Slope", 2.0f },
+                         { "HighCut Freq", 3400.0f }, { "HighCut Slope", 2.0f },
+                         { "Peak Freq", 1500.0f }, { "Peak Gain", 6.0f }, { "Peak Quality", 0.8f } } },
+        { "Mid/Side Wide", { { "Channel Mode", (float) ChannelMode_MidSide },
+                             { getChannelParameterID(1, "LowCut Freq"), 150.0f }, { getChannelParameterID(1, "LowCut Slope"), 1.0f },
+                             { getBandParameterID(0, "Type", 1), (float) BandType_HighShelf }, { getBandParameterID(0, "Freq", 1), 8000.0f },
+                             { getBandParameterID(0, "Gain", 1), 3.0f } } }
+    };
+    
+    designs.resize(presets.size());
+}
+
+juce::String PresetBank::getName(int index) const {
+    return juce::isPositiveAndBelow(index, getNumPresets()) ? presets[(size_t) index].name : juce::String();
+}
+
+void PresetBank::applyParameters(int index, juce::AudioProcessorValueTreeState& apvts) const {
+    
+    const auto& values = presets[(size_t) index].values;
+    
+    for(const auto& id : getChainParameterIDs()) {
+        auto* parameter = apvts.getParameter(id);
+        
+        //the design mode is a setting of the instance, presets leave it alone
+        if(parameter == nullptr || id == "Filter Design")
+            continue;
+        
+        const auto value = std::find_if(values.begin(), values.end(), [&id](const auto& entry) { return entry.first == id; });
+        const auto normalised = value != values.end() ? parameter->convertTo0to1(value->second) : parameter->getDefaultValue();
+        
+        if(normalised != parameter->getValue())
+            parameter->setValueNotifyingHost(normalised);
+    }
+}
+
+juce::ValueTree PresetBank::getState(int index) const {
+    
+    //the same layout the APVTS writes, so PluginState reads it with the parameter defaults
+    juce::ValueTree state("Parameters");
+    
+    for(const auto& value : presets[(size_t) index].values)
+        state.appendChild(juce::ValueTree("PARAM", { { "id", value.first }, { "value", value.second } }), nullptr);
+    
+    return state;
+}
+
+void PresetBank::prepare(double sampleRate) {
+    
+    for(int index = 0; index < getNumPresets(); index++) {
+        const auto state = getState(index);
+        auto& design = designs[(size_t) index];
+        
+        design.channelMode = getChannelMode(state);
+        design.settings[0] = getChainSettings(state);
+        design.settings[1] = design.channelMode == ChannelMode_Linked ? design.settings[0] : getChainSettings(state, 1);
+        design.independent = !(design.settings[1] == design.settings[0]);
+        
+        for(int mode = 0; mode < numDesignModes; mode++) {
+            for(int order = 0; order <= maxOversamplingOrder; order++) {
+                for(int set = 0; set < (design.independent ? numChannelSets : 1); set++) {
+                    auto settings = design.settings[(size_t) set];
+                    settings.designMode = static_cast<DesignMode>(mode);
+                    coefficientCache->makeChainCoefficients(design.coefficients[(size_t) mode][(size_t) order][(size_t) set], settings, sampleRate * (1 << order));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <JuceHeader.h>
+#include "CoefficientCache.h"
+#include "FilterChain.h"
+#include "OversamplingStage.h"
+
+//Factory presets of the chain parameters: cuts, peak, bands and channel mode.
+//Their coefficients are designed for every design mode and oversampling factor when the bank is prepared,
+//so the audio thread switches to a preset without designing or allocating anything.
+class PresetBank
+{
+public:
+    struct Design {
+        std::array<ChainSettings, numChannelSets> settings;
+        ChannelMode channelMode { ChannelMode_Linked };
+        //the second set differs from the first; only then is its design used
+        bool independent { false };
+        //one design per design mode and oversampling order
+        std::array<std::array<std::array<ChainCoefficients, numChannelSets>, maxOversamplingOrder + 1>, numDesignModes> coefficients;
+    };
+    
+    PresetBank();
+    
+    int getNumPresets() const noexcept { return (int) presets.size(); }
+    juce::String getName(int index) const;
+    
+    //message thread: sets the chain parameters to the preset, those it does not name to their defaults;
+    //the filter design stays as it is
+    void applyParameters(int index, juce::AudioProcessorValueTreeState& apvts) const;
+    
+    //message thread, audio stopped
+    void prepare(double sampleRate);
+    const Design& getDesign(int index) const noexcept { return designs[(size_t) index]; }
+    
+private:
+    struct Preset {
+        juce::String name;
+        std::vector<std::pair<juce::String, float>> values;
+    };
+    
+    std::vector<Preset> presets;
+    std::vector<Design> designs;
+    //every instance prepares the same presets at the same rates
+    juce::SharedResourcePointer<CoefficientCache> coefficientCache;
+    
+    juce::ValueTree getState(int index) const;
+};
@@ -0,0 +1,219 @@
+#include "Profiler.h"
+
+#if FILTERPLUGIN_PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+    //long enough that the two clock reads are a negligible part of the interval
+    constexpr std::uint64_t calibrationNanosecondsNeeded = 100000000;
+}
+
+std::uint64_t Profiler::readNanoseconds() noexcept
+{
+    return (std::uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::prepare(double newSampleRate) noexcept
+{
+    sampleRate = newSampleRate;
+
+    //the counter keeps its rate, so a calibration carries over to the next prepare
+    if(ticksPerSecond.load(std::memory_order_relaxed) == 0) {
+        calibrationTicks = readTicks();
+        calibrationNanoseconds = readNanoseconds();
+    }
+
+    reset();
+}
+
+void Profiler::reset() noexcept
+{
+    resetGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Profiler::record(ProfileSection section, std::uint64_t ticks) noexcept
+{
+    auto& stats = sections[(size_t) section];
+    const auto generation = resetGeneration.load(std::memory_order_relaxed);
+
+    if(stats.generation.load(std::memory_order_relaxed) != generation) {
+        for(auto* value : { &stats.count, &stats.totalTicks, &stats.maxTicks, &stats.worstBlockTicks })
+            value->store(0, std::memory_order_relaxed);
+
+        stats.generation.store(generation, std::memory_order_relaxed);
+    }
+
+    add(stats.count, 1);
+    add(stats.totalTicks, ticks);
+
+    if(ticks > stats.maxTicks.load(std::memory_order_relaxed))
+        stats.maxTicks.store(ticks, std::memory_order_relaxed);
+
+    if(section != ProfileSection_Design)
+        blockTicks[(size_t) section] += ticks;
+}
+
+void Profiler::beginBlock(int numSamples) noexcept
+{
+    blockTicks.fill(0);
+    blockNumSamples = numSamples;
+}
+
+void Profiler::endBlock(std::uint64_t ticks) noexcept
+{
+    record(ProfileSection_Block, ticks);
+
+    auto rate = ticksPerSecond.load(std::memory_order_relaxed);
+
+    if(rate == 0) {
+        const auto elapsed = readNanoseconds() - calibrationNanoseconds;
+
+        if(elapsed < calibrationNanosecondsNeeded)
+            return;
+
+        rate = (double) (readTicks() - calibrationTicks) * 1.0e9 / (double) elapsed;
+        ticksPerSecond.store(rate, std::memory_order_relaxed);
+    }
+
+    const auto generation = resetGeneration.load(std::memory_order_relaxed);
+
+    if(blockGeneration != generation) {
+        for(auto& bin : loadHistogram)
+            bin.store(0, std::memory_order_relaxed);
+
+        numBlocks.store(0, std::memory_order_relaxed);
+        numOverruns.store(0, std::memory_order_relaxed);
+        totalLoad.store(0, std::memory_order_relaxed);
+        worstLoad.store(0, std::memory_order_relaxed);
+        blockGeneration = generation;
+    }
+
+    if(blockNumSamples <= 0)
+        return;
+
+    const auto deadline = blockNumSamples / sampleRate * rate;
+    const auto load = (double) ticks / deadline;
+    auto& bin = loadHistogram[(size_t) std::min((int) (load * 20.0), numLoadBins - 1)];
+
+    bin.store(bin.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    add(numBlocks, 1);
+    totalLoad.store(totalLoad.load(std::memory_order_relaxed) + load, std::memory_order_relaxed);
+
+    if(load > 1.0)
+        add(numOverruns, 1);
+
+    //the worst block keeps where its time went
+    if(load > worstLoad.load(std::memory_order_relaxed)) {
+        worstLoad.store(load, std::memory_order_relaxed);
+
+        for(int section = 0; section < ProfileSection_Design; section++)
+            sections[(size_t) section].worstBlockTicks.store(blockTicks[(size_t) section], std::memory_order_relaxed);
+    }
+}
+
+Profiler::Snapshot Profiler::getSnapshot() const noexcept
+{
+    Snapshot snapshot;
+    const auto rate = ticksPerSecond.load(std::memory_order_relaxed);
+    snapshot.calibrated = rate > 0;
+
+    if(!snapshot.calibrated)
+        return snapshot;
+
+    const auto microsecondsPerTick = 1.0e6 / rate;
+    const auto generation = resetGeneration.load(std::memory_order_relaxed);
+
+    for(size_t i = 0; i < sections.size(); i++) {
+        const auto& stats = sections[i];
+        auto& section = snapshot.sections[i];
+
+        //not written since the last reset
+        if(stats.generation.load(std::memory_order_relaxed) != generation)
+            continue;
+
+        section.count = stats.count.load(std::memory_order_relaxed);
+        section.averageMicroseconds = section.count > 0 ? (double) stats.totalTicks.load(std::memory_order_relaxed) / (double) section.count * microsecondsPerTick : 0.0;
+        section.maxMicroseconds = (double) stats.maxTicks.load(std::memory_order_relaxed) * microsecondsPerTick;
+        section.worstBlockMicroseconds = (double) stats.worstBlockTicks.load(std::memory_order_relaxed) * microsecondsPerTick;
+    }
+
+    for(size_t i = 0; i < loadHistogram.size(); i++)
+        snapshot.loadHistogram[i] = loadHistogram[i].load(std::memory_order_relaxed);
+
+    snapshot.numBlocks = numBlocks.load(std::memory_order_relaxed);
+    snapshot.numOverruns = numOverruns.load(std::memory_order_relaxed);
+    snapshot.averageLoad = snapshot.numBlocks > 0 ? totalLoad.load(std::memory_order_relaxed) / (double) snapshot.numBlocks : 0.0;
+    snapshot.worstLoad = worstLoad.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+std::string Profiler::dump() const
+{
+    const auto snapshot = getSnapshot();
+
+    if(!snapshot.calibrated)
+        return "FilterPlugin profile: not calibrated yet\n";
+
+    char line[160];
+    std::string text;
+
+    std::snprintf(line, sizeof(line), "FilterPlugin profile: %llu blocks, load %.1f%% average, %.1f%% worst, %llu over the deadline\n",
+                  (unsigned long long) snapshot.numBlocks, snapshot.averageLoad * 100.0, snapshot.worstLoad * 100.0,
+                  (unsigned long long) snapshot.numOverruns);
+    text += line;
+
+    std::snprintf(line, sizeof(line), "%-14s %10s %10s %10s %12s\n", "section", "count", "avg us", "max us", "worst blk us");
+    text += line;
+
+    for(int i = 0; i < numProfileSections; i++) {
+        const auto& section = snapshot.sections[(size_t) i];
+
+        if(section.count == 0)
+            continue;
+
+        std::snprintf(line, sizeof(line), "%-14s %10llu %10.2f %10.2f %12.2f\n", getSectionName(static_cast<ProfileSection>(i)),
+                      (unsigned long long) section.count, section.averageMicroseconds, section.maxMicroseconds, section.worstBlockMicroseconds);
+        text += line;
+    }
+
+    text += "load histogram:\n";
+
+    for(int i = 0; i < numLoadBins; i++) {
+        const auto count = snapshot.loadHistogram[(size_t) i];
+
+        if(count == 0)
+            continue;
+
+        if(i == numLoadBins - 1)
+            std::snprintf(line, sizeof(line), "  >= %3d%% %10u\n", i * 5, (unsigned) count);
+        else
+            std::snprintf(line, sizeof(line), "  %3d-%3d%% %9u\n", i * 5, i * 5 + 5, (unsigned) count);
+
+        text += line;
+    }
+
+    return text;
+}
+
+const char* Profiler::getSectionName(ProfileSection section) noexcept
+{
+    switch(section) {
+        case ProfileSection_Block:        return "block";
+        case ProfileSection_Update:       return "update";
+        case ProfileSection_Dynamics:     return "dynamics";
+        case ProfileSection_Redesign:     return "redesign";
+        case ProfileSection_Chain:        return "chain";
+        case ProfileSection_Oversampling: return "oversampling";
+        case ProfileSection_LinearPhase:  return "linear phase";
+        case ProfileSection_Analyser:     return "analyser";
+        case ProfileSection_Design:       return "design (bg)";
+        case numProfileSections:
+        default:                          return "";
+    }
+}
+
+#endif
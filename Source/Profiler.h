@@ -0,0 +1,165 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+//Per-instance timing of the audio thread, compiled only with FILTERPLUGIN_PROFILING=1.
+//Each value has one writer and is read with relaxed atomics, so nothing locks or allocates.
+
+#ifndef FILTERPLUGIN_PROFILING
+ #define FILTERPLUGIN_PROFILING 0
+#endif
+
+#if FILTERPLUGIN_PROFILING
+ #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h>
+  #define FILTERPLUGIN_PROFILING_TSC 1
+ #elif defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  #define FILTERPLUGIN_PROFILING_TSC 1
+ #else
+  #include <chrono>
+  #define FILTERPLUGIN_PROFILING_TSC 0
+ #endif
+#endif
+
+enum ProfileSection {
+    ProfileSection_Block,
+    //pulling and applying coefficient updates
+    ProfileSection_Update,
+    ProfileSection_Dynamics,
+    //coefficient redesigns on the audio thread, for ramps and the dynamic peak
+    ProfileSection_Redesign,
+    ProfileSection_Chain,
+    //up and downsampling, including the chain in between
+    ProfileSection_Oversampling,
+    ProfileSection_LinearPhase,
+    ProfileSection_Analyser,
+    //the only section timed off the audio thread: designs on the coefficient updater thread
+    ProfileSection_Design,
+    numProfileSections
+};
+
+class Profiler
+{
+public:
+#if FILTERPLUGIN_PROFILING
+    //5% of the deadline per bin up to 200%, then one bin for everything slower
+    static constexpr int numLoadBins = 41;
+
+    //message thread, audio stopped; clears everything
+    void prepare(double sampleRate) noexcept;
+    //any thread; the writers clear their values before they next write
+    void reset() noexcept;
+
+    struct ScopedTimer
+    {
+        ScopedTimer(Profiler& p, ProfileSection s) noexcept : profiler(p), section(s), start(readTicks()) { }
+        ~ScopedTimer() noexcept { profiler.record(section, readTicks() - start); }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Profiler& profiler;
+        ProfileSection section;
+        std::uint64_t start;
+    };
+
+    //audio thread, around everything processBlock does
+    struct ScopedBlock
+    {
+        ScopedBlock(Profiler& p, int numSamples) noexcept : profiler(p), start(readTicks()) { profiler.beginBlock(numSamples); }
+        ~ScopedBlock() noexcept { profiler.endBlock(readTicks() - start); }
+
+        ScopedBlock(const ScopedBlock&) = delete;
+        ScopedBlock& operator=(const ScopedBlock&) = delete;
+
+    private:
+        Profiler& profiler;
+        std::uint64_t start;
+    };
+
+    struct SectionSnapshot
+    {
+        std::uint64_t count { 0 };
+        double averageMicroseconds { 0 }, maxMicroseconds { 0 };
+        //time spent in the section during the worst block
+        double worstBlockMicroseconds { 0 };
+    };
+
+    struct Snapshot
+    {
+        //false until the tick rate is known; times are 0 until then
+        bool calibrated { false };
+        std::array<SectionSnapshot, numProfileSections> sections;
+        std::array<std::uint32_t, numLoadBins> loadHistogram {};
+        std::uint64_t numBlocks { 0 }, numOverruns { 0 };
+        //block time against the block's deadline, 1 is the whole budget
+        double averageLoad { 0 }, worstLoad { 0 };
+    };
+
+    //any thread
+    Snapshot getSnapshot() const noexcept;
+    std::string dump() const;
+
+    static const char* getSectionName(ProfileSection section) noexcept;
+
+private:
+    static std::uint64_t readTicks() noexcept
+    {
+       #if FILTERPLUGIN_PROFILING_TSC
+        return __rdtsc();
+       #elif defined(__aarch64__)
+        std::uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+       #else
+        return (std::uint64_t) std::chrono::steady_clock::now().time_since_epoch().count();
+       #endif
+    }
+
+    static std::uint64_t readNanoseconds() noexcept;
+
+    void record(ProfileSection section, std::uint64_t ticks) noexcept;
+    void beginBlock(int numSamples) noexcept;
+    void endBlock(std::uint64_t ticks) noexcept;
+
+    //written by one thread only, so updates are a relaxed load and store
+    static void add(std::atomic<std::uint64_t>& value, std::uint64_t amount) noexcept
+    {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    struct SectionStats
+    {
+        std::atomic<std::uint64_t> count { 0 }, totalTicks { 0 }, maxTicks { 0 }, worstBlockTicks { 0 };
+        //reset generation the writer last cleared for; older values are not reported
+        std::atomic<std::uint32_t> generation { 0 };
+    };
+
+    std::array<SectionStats, numProfileSections> sections;
+    std::array<std::atomic<std::uint32_t>, numLoadBins> loadHistogram {};
+    std::atomic<std::uint64_t> numBlocks { 0 }, numOverruns { 0 };
+    std::atomic<double> totalLoad { 0 }, worstLoad { 0 };
+    std::atomic<std::uint32_t> resetGeneration { 0 };
+    std::uint32_t blockGeneration { 0 };
+
+    //audio thread: ticks per section in the current block
+    std::array<std::uint64_t, numProfileSections> blockTicks {};
+    int blockNumSamples { 0 };
+    double sampleRate { 44100.0 };
+
+    //tick rate, measured against steady_clock once enough time has passed since prepare
+    std::atomic<double> ticksPerSecond { 0 };
+    std::uint64_t calibrationTicks { 0 }, calibrationNanoseconds { 0 };
+#else
+    struct ScopedTimer { ScopedTimer(Profiler&, ProfileSection) noexcept { } };
+    struct ScopedBlock { ScopedBlock(Profiler&, int) noexcept { } };
+
+    void prepare(double) noexcept { }
+    void reset() noexcept { }
+    std::string dump() const { return {}; }
+#endif
+};
@@ -0,0 +1,290 @@
+#include "RealtimeSafety.h"
+
+#if FILTERPLUGIN_RT_CHECKS
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__GLIBC__)
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <unistd.h>
+ //malloc/free and mutexes can be interposed directly; the TLS model must not allocate
+ #define FILTERPLUGIN_RT_INTERPOSE_LIBC 1
+ #define FILTERPLUGIN_RT_INTERPOSE_DYLD 0
+ #define FILTERPLUGIN_RT_TLS __attribute__((tls_model("initial-exec")))
+#elif defined(__APPLE__)
+ #include <cstdint>
+ #include <malloc/malloc.h>
+ #include <os/lock.h>
+ #include <pthread.h>
+ #include <unistd.h>
+ //dyld applies __interpose entries to images loaded at launch (the benchmark app), not to a
+ //bundle a host loads later, where only operator new/delete are seen
+ #define FILTERPLUGIN_RT_INTERPOSE_LIBC 0
+ #define FILTERPLUGIN_RT_INTERPOSE_DYLD 1
+#else
+ #include <cstdio>
+ #define FILTERPLUGIN_RT_INTERPOSE_LIBC 0
+ #define FILTERPLUGIN_RT_INTERPOSE_DYLD 0
+ #define FILTERPLUGIN_RT_TLS
+#endif
+
+namespace RealtimeSafety
+{
+    namespace
+    {
+       #if FILTERPLUGIN_RT_INTERPOSE_DYLD
+        //thread_local storage is allocated with malloc on first use here, which would recurse into
+        //the hooks; a pthread key's slot is part of the thread
+        pthread_key_t depthKey;
+        bool hasDepthKey = false;
+        [[maybe_unused]] const bool depthKeyCreated = [] { hasDepthKey = pthread_key_create(&depthKey, nullptr) == 0; return hasDepthKey; }();
+
+        int getDepth() noexcept { return hasDepthKey ? (int) (std::intptr_t) pthread_getspecific(depthKey) : 0; }
+
+        void setDepth(int depth) noexcept
+        {
+            if(hasDepthKey)
+                pthread_setspecific(depthKey, (void*) (std::intptr_t) depth);
+        }
+       #else
+        thread_local int realtimeDepth FILTERPLUGIN_RT_TLS = 0;
+
+        int getDepth() noexcept { return realtimeDepth; }
+        void setDepth(int depth) noexcept { realtimeDepth = depth; }
+       #endif
+
+        std::atomic<int> violations { 0 };
+        std::atomic<bool> trapOnViolation { true };
+
+        void writeToStderr(const char* text) noexcept
+        {
+           #if FILTERPLUGIN_RT_INTERPOSE_LIBC || FILTERPLUGIN_RT_INTERPOSE_DYLD
+            auto ignored = ::write(2, text, std::strlen(text));
+            (void) ignored;
+           #else
+            std::fputs(text, stderr);
+           #endif
+        }
+    }
+
+    ScopedRealtimeCheck::ScopedRealtimeCheck() noexcept { setDepth(getDepth() + 1); }
+    ScopedRealtimeCheck::~ScopedRealtimeCheck() noexcept { setDepth(getDepth() - 1); }
+
+    ScopedRealtimeCheckSuspender::ScopedRealtimeCheckSuspender() noexcept : savedDepth(getDepth()) { setDepth(0); }
+    ScopedRealtimeCheckSuspender::~ScopedRealtimeCheckSuspender() noexcept { setDepth(savedDepth); }
+
+    bool isInRealtimeScope() noexcept { return getDepth() > 0; }
+
+    void reportViolation(const char* what) noexcept
+    {
+        ScopedRealtimeCheckSuspender suspender;
+        violations.fetch_add(1, std::memory_order_relaxed);
+
+        if(trapOnViolation.load(std::memory_order_relaxed)) {
+            writeToStderr("FilterPlugin: real-time violation, ");
+            writeToStderr(what);
+            writeToStderr(" called inside processBlock\n");
+            std::abort();
+        }
+    }
+
+    int getViolationCount() noexcept { return violations.load(); }
+    void resetViolationCount() noexcept { violations.store(0); }
+    void setTrapOnViolation(bool shouldTrap) noexcept { trapOnViolation.store(shouldTrap); }
+}
+
+static inline void checkRealtime(const char* what) noexcept
+{
+    if(RealtimeSafety::isInRealtimeScope())
+        RealtimeSafety::reportViolation(what);
+}
+
+#if FILTERPLUGIN_RT_INTERPOSE_LIBC
+
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void __libc_free(void*);
+
+    void* malloc(size_t size)
+    {
+        checkRealtime("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        checkRealtime("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, size_t size)
+    {
+        checkRealtime("realloc");
+        return __libc_realloc(ptr, size);
+    }
+
+    void free(void* ptr)
+    {
+        if(ptr != nullptr)
+            checkRealtime("free");
+
+        __libc_free(ptr);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        using LockFunction = int (*)(pthread_mutex_t*);
+        static std::atomic<LockFunction> next { nullptr };
+
+        auto lock = next.load(std::memory_order_acquire);
+
+        if(lock == nullptr) {
+            lock = reinterpret_cast<LockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+            next.store(lock, std::memory_order_release);
+        }
+
+        checkRealtime("pthread_mutex_lock");
+        return lock(mutex);
+    }
+}
+
+//operator new goes through the malloc above
+static inline void checkRealtimeNew(const char*) noexcept { }
+
+#else
+
+#if FILTERPLUGIN_RT_INTERPOSE_DYLD
+
+//dyld points every other image's calls to the second function of a pair at the first; calls from
+//this image itself (operator new below) are left alone
+#define FILTERPLUGIN_RT_INTERPOSE(replacement, original) \
+    __attribute__((used, section("__DATA,__interpose"))) static const struct { const void* from; const void* to; } \
+        interpose_##original = { (const void*) (unsigned long) &replacement, (const void*) (unsigned long) &original };
+
+namespace
+{
+    void* realtimeMalloc(size_t size)
+    {
+        checkRealtime("malloc");
+        return malloc(size);
+    }
+
+    void* realtimeCalloc(size_t count, size_t size)
+    {
+        checkRealtime("calloc");
+        return calloc(count, size);
+    }
+
+    void* realtimeRealloc(void* ptr, size_t size)
+    {
+        checkRealtime("realloc");
+        return realloc(ptr, size);
+    }
+
+    void realtimeFree(void* ptr)
+    {
+        if(ptr != nullptr)
+            checkRealtime("free");
+
+        free(ptr);
+    }
+
+    int realtimePosixMemalign(void** ptr, size_t alignment, size_t size)
+    {
+        checkRealtime("posix_memalign");
+        return posix_memalign(ptr, alignment, size);
+    }
+
+    //Foundation and CoreFoundation allocate from zones directly
+    void* realtimeZoneMalloc(malloc_zone_t* zone, size_t size)
+    {
+        checkRealtime("malloc_zone_malloc");
+        return malloc_zone_malloc(zone, size);
+    }
+
+    void realtimeZoneFree(malloc_zone_t* zone, void* ptr)
+    {
+        if(ptr != nullptr)
+            checkRealtime("malloc_zone_free");
+
+        malloc_zone_free(zone, ptr);
+    }
+
+    //std::mutex and juce::CriticalSection
+    int realtimeMutexLock(pthread_mutex_t* mutex)
+    {
+        checkRealtime("pthread_mutex_lock");
+        return pthread_mutex_lock(mutex);
+    }
+
+    void realtimeUnfairLock(os_unfair_lock_t lock)
+    {
+        checkRealtime("os_unfair_lock_lock");
+        os_unfair_lock_lock(lock);
+    }
+}
+
+FILTERPLUGIN_RT_INTERPOSE(realtimeMalloc, malloc)
+FILTERPLUGIN_RT_INTERPOSE(realtimeCalloc, calloc)
+FILTERPLUGIN_RT_INTERPOSE(realtimeRealloc, realloc)
+FILTERPLUGIN_RT_INTERPOSE(realtimeFree, free)
+FILTERPLUGIN_RT_INTERPOSE(realtimePosixMemalign, posix_memalign)
+FILTERPLUGIN_RT_INTERPOSE(realtimeZoneMalloc, malloc_zone_malloc)
+FILTERPLUGIN_RT_INTERPOSE(realtimeZoneFree, malloc_zone_free)
+FILTERPLUGIN_RT_INTERPOSE(realtimeMutexLock, pthread_mutex_lock)
+FILTERPLUGIN_RT_INTERPOSE(realtimeUnfairLock, os_unfair_lock_lock)
+
+#endif
+
+static inline void checkRealtimeNew(const char* what) noexcept { checkRealtime(what); }
+
+#endif
+
+void* operator new(std::size_t size)
+{
+    checkRealtimeNew("operator new");
+
+    if(auto* ptr = std::malloc(size != 0 ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    checkRealtimeNew("operator new");
+    return std::malloc(size != 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return ::operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if(ptr != nullptr)
+        checkRealtimeNew("operator delete");
+
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept                        { ::operator delete(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept             { ::operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept           { ::operator delete(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept   { ::operator delete(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { ::operator delete(ptr); }
+
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+//Debug-only trap for allocations and locks on the audio thread.
+//Build with FILTERPLUGIN_RT_CHECKS=1 (the Debug configuration does) and wrap the
+//real-time code in a RealtimeSafety::ScopedRealtimeCheck. Any operator new/delete,
+//malloc/free or mutex lock taken inside the scope on that thread is counted and, unless
+//disabled with setTrapOnViolation(false), aborts with a message on stderr. On macOS a
+//plugin bundle only sees operator new/delete, an executable sees all of them.
+//With the flag off everything here compiles to nothing.
+
+#ifndef FILTERPLUGIN_RT_CHECKS
+ #define FILTERPLUGIN_RT_CHECKS 0
+#endif
+
+namespace RealtimeSafety
+{
+#if FILTERPLUGIN_RT_CHECKS
+    struct ScopedRealtimeCheck
+    {
+        ScopedRealtimeCheck() noexcept;
+        ~ScopedRealtimeCheck() noexcept;
+
+        ScopedRealtimeCheck(const ScopedRealtimeCheck&) = delete;
+        ScopedRealtimeCheck& operator=(const ScopedRealtimeCheck&) = delete;
+    };
+
+    //code that is allowed to allocate inside a checked scope (e.g. the checker's own reporting)
+    struct ScopedRealtimeCheckSuspender
+    {
+        ScopedRealtimeCheckSuspender() noexcept;
+        ~ScopedRealtimeCheckSuspender() noexcept;
+
+        ScopedRealtimeCheckSuspender(const ScopedRealtimeCheckSuspender&) = delete;
+        ScopedRealtimeCheckSuspender& operator=(const ScopedRealtimeCheckSuspender&) = delete;
+
+    private:
+        int savedDepth;
+    };
+
+    bool isInRealtimeScope() noexcept;
+    void reportViolation(const char* what) noexcept;
+
+    int getViolationCount() noexcept;
+    void resetViolationCount() noexcept;
+    void setTrapOnViolation(bool shouldTrap) noexcept;
+#else
+    struct ScopedRealtimeCheck { };
+    struct ScopedRealtimeCheckSuspender { };
+
+    inline bool isInRealtimeScope() noexcept { return false; }
+    inline int getViolationCount() noexcept { return 0; }
+    inline void resetViolationCount() noexcept { }
+    inline void setTrapOnViolation(bool) noexcept { }
+#endif
+}
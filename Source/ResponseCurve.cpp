@@ -0,0 +1,82 @@
+#include "ResponseCurve.h"
+#include <algorithm>
+#include <cmath>
+
+static bool operator==(const BiquadCoefficients& a, const BiquadCoefficients& b) noexcept {
+    return a.b0 == b.b0 && a.b1 == b.b1 && a.b2 == b.b2 && a.a1 == b.a1 && a.a2 == b.a2;
+}
+
+
+void ResponseCurve::setFrequencies(int numPoints, double minFrequency, double maxFrequency, double sampleRate) {
+
+    const auto size = (size_t) std::max(numPoints, 0);
+
+    phi.resize(size);
+    power.resize(size);
+    decibels.assign(size, 0.0f);
+
+    for(auto* stage : { &lowCut, &peak, &bands, &highCut }) {
+        stage->decibels.assign(size, 0.0f);
+        stage->valid = false;
+    }
+
+    for(size_t i = 0; i < size; i++) {
+        const auto frequency = minFrequency * std::pow(maxFrequency / minFrequency, (double) i / (double) size);
+        const auto s = std::sin(BiquadDesign::pi * frequency / sampleRate);
+        phi[i] = s * s;
+    }
+}
+
+void ResponseCurve::evaluate(Stage& stage, const BiquadCoefficients* coefficients, int numStages) {
+
+    const auto numPoints = phi.size();
+    std::fill(power.begin(), power.end(), 1.0);
+
+    for(int s = 0; s < numStages; s++) {
+        const auto& c = coefficients[s];
+
+        //|N|^2 = (b0 + b1 + b2)^2 - 4 (b0 b1 + 4 b0 b2 + b1 b2) phi + 16 b0 b2 phi^2, same for D with a0 = 1
+        const double b0 = c.b0, b1 = c.b1, b2 = c.b2, a1 = c.a1, a2 = c.a2;
+        const auto bSum = b0 + b1 + b2, aSum = 1.0 + a1 + a2;
+        const auto n0 = bSum * bSum, n1 = -4.0 * (b0 * b1 + 4.0 * b0 * b2 + b1 * b2), n2 = 16.0 * b0 * b2;
+        const auto d0 = aSum * aSum, d1 = -4.0 * (a1 + 4.0 * a2 + a1 * a2), d2 = 16.0 * a2;
+
+        for(size_t i = 0; i < numPoints; i++) {
+            const auto p = phi[i];
+            const auto numerator = n0 + p * (n1 + p * n2);
+            const auto denominator = d0 + p * (d1 + p * d2);
+            power[i] *= numerator / denominator;
+        }
+    }
+
+    //10 log10 of the power, floored well below the drawn range
+    for(size_t i = 0; i < numPoints; i++)
+        stage.decibels[i] = (float) (10.0 * std::log10(std::max(power[i], 1.0e-20)));
+
+    stage.coefficients.assign(coefficients, coefficients + numStages);
+    stage.valid = true;
+}
+
+bool ResponseCurve::update(const ChainCoefficients& chainCoefficients) {
+
+    bool changed = false;
+
+    auto refresh = [this, &changed](Stage& stage, const BiquadCoefficients* coefficients, int numStages) {
+        if(stage.valid && std::equal(stage.coefficients.begin(), stage.coefficients.end(), coefficients, coefficients + numStages))
+            return;
+
+        evaluate(stage, coefficients, numStages);
+        changed = true;
+    };
+
+    refresh(lowCut, chainCoefficients.lowCut.stages.data(), chainCoefficients.lowCut.numStages);
+    refresh(peak, &chainCoefficients.peak, 1);
+    refresh(bands, chainCoefficients.bands.stages.data(), chainCoefficients.bands.numBands);
+    refresh(highCut, chainCoefficients.highCut.stages.data(), chainCoefficients.highCut.numStages);
+
+    if(changed)
+        for(size_t i = 0; i < decibels.size(); i++)
+            decibels[i] = lowCut.decibels[i] + peak.decibels[i] + bands.decibels[i] + highCut.decibels[i];
+
+    return changed;
+}
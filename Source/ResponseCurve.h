@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include "FilterChain.h"
+
+//Magnitude response of a ChainCoefficients on a fixed log-frequency grid.
+//The grid (one point per pixel column) is built once per width and sample rate.
+//LowCut, Peak, the bands and HighCut are cached separately, so a change to one stage only
+//re-evaluates that stage. The per-point loops are branch free so they vectorise.
+class ResponseCurve
+{
+public:
+    //log-spaced points from minFrequency to maxFrequency, like juce::mapToLog10
+    void setFrequencies(int numPoints, double minFrequency, double maxFrequency, double sampleRate);
+
+    //returns true if any stage changed since the last update
+    bool update(const ChainCoefficients& chainCoefficients);
+
+    int getNumPoints() const noexcept { return (int) decibels.size(); }
+    const float* getDecibels() const noexcept { return decibels.data(); }
+
+private:
+    struct Stage {
+        std::vector<float> decibels;
+        std::vector<BiquadCoefficients> coefficients;
+        bool valid { false };
+    };
+
+    void evaluate(Stage& stage, const BiquadCoefficients* coefficients, int numStages);
+
+    //phi = sin^2(w / 2) for every point; |H|^2 is a quadratic in phi, which stays
+    //accurate at low frequencies where the expanded cos(w) form cancels badly
+    std::vector<double> phi;
+    std::vector<double> power;
+
+    Stage lowCut, peak, bands, highCut;
+    std::vector<float> decibels;
+};
@@ -0,0 +1,631 @@
+#pragma once
+#include <JuceHeader.h>
+#include "FilterChain.h"
+
+//Per-sample update of one section for every lane of Vec. A topology holds its own
+//coefficient form, loaded lane by lane from the double BiquadCoefficients (nullptr: the
+//lane passes its input through untouched), and its own state.
+
+//zeroes one lane of a register and leaves the others
+template<typename Vec>
+inline void clearLane(Vec& v, size_t lane) noexcept
+{
+    alignas(64) typename Vec::ElementType values[Vec::SIMDNumElements];
+    v.copyToRawArray(values);
+    values[lane] = 0;
+    v = Vec::fromRawArray(values);
+}
+
+//transposed direct form II, the same arithmetic as processSample / MonoChain
+template<typename Vec>
+struct TransposedDirectForm
+{
+    using SampleType = typename Vec::ElementType;
+
+    struct Coefficients { Vec b0, b1, b2, a1, a2; };
+    struct State { Vec s1, s2; };
+
+    static void setCoefficients(Coefficients& v, const BiquadCoefficients& c) noexcept
+    {
+        v.b0 = Vec::expand((SampleType) c.b0);
+        v.b1 = Vec::expand((SampleType) c.b1);
+        v.b2 = Vec::expand((SampleType) c.b2);
+        v.a1 = Vec::expand((SampleType) c.a1);
+        v.a2 = Vec::expand((SampleType) c.a2);
+    }
+
+    static void setCoefficients(Coefficients& v, const BiquadCoefficients* const* lanes) noexcept
+    {
+        alignas(64) SampleType b0[Vec::SIMDNumElements], b1[Vec::SIMDNumElements], b2[Vec::SIMDNumElements];
+        alignas(64) SampleType a1[Vec::SIMDNumElements], a2[Vec::SIMDNumElements];
+
+        for(size_t lane = 0; lane < Vec::SIMDNumElements; lane++) {
+            const auto c = lanes[lane] != nullptr ? *lanes[lane] : BiquadCoefficients();
+            b0[lane] = (SampleType) c.b0;
+            b1[lane] = (SampleType) c.b1;
+            b2[lane] = (SampleType) c.b2;
+            a1[lane] = (SampleType) c.a1;
+            a2[lane] = (SampleType) c.a2;
+        }
+
+        v.b0 = Vec::fromRawArray(b0);
+        v.b1 = Vec::fromRawArray(b1);
+        v.b2 = Vec::fromRawArray(b2);
+        v.a1 = Vec::fromRawArray(a1);
+        v.a2 = Vec::fromRawArray(a2);
+    }
+
+    static void reset(State& s) noexcept { s.s1 = s.s2 = Vec::expand((SampleType) 0); }
+    static void resetLane(State& s, size_t lane) noexcept { clearLane(s.s1, lane); clearLane(s.s2, lane); }
+
+    forcedinline static Vec process(const Coefficients& c, State& s, Vec x) noexcept
+    {
+        const auto y = c.b0 * x + s.s1;
+        s.s1 = c.b1 * x - c.a1 * y + s.s2;
+        s.s2 = c.b2 * x - c.a2 * y;
+        return y;
+    }
+};
+
+//trapezoidal state variable form (see BiquadDesign::toStateVariable): a few more
+//operations per section, but low cutoffs stay clean in float
+template<typename Vec>
+struct StateVariable
+{
+    using SampleType = typename Vec::ElementType;
+
+    struct Coefficients { Vec a1, a2, a3, m0, m1, m2; };
+    struct State { Vec ic1, ic2; };
+
+    static void setCoefficients(Coefficients& v, const BiquadCoefficients& c) noexcept
+    {
+        const auto sv = BiquadDesign::toStateVariable(c);
+        v.a1 = Vec::expand((SampleType) sv.a1);
+        v.a2 = Vec::expand((SampleType) sv.a2);
+        v.a3 = Vec::expand((SampleType) sv.a3);
+        v.m0 = Vec::expand((SampleType) sv.m0);
+        v.m1 = Vec::expand((SampleType) sv.m1);
+        v.m2 = Vec::expand((SampleType) sv.m2);
+    }
+
+    //a pass-through lane gets the default coefficients, which also hold its integrators still
+    static void setCoefficients(Coefficients& v, const BiquadCoefficients* const* lanes) noexcept
+    {
+        alignas(64) SampleType a1[Vec::SIMDNumElements], a2[Vec::SIMDNumElements], a3[Vec::SIMDNumElements];
+        alignas(64) SampleType m0[Vec::SIMDNumElements], m1[Vec::SIMDNumElements], m2[Vec::SIMDNumElements];
+
+        for(size_t lane = 0; lane < Vec::SIMDNumElements; lane++) {
+            const auto sv = lanes[lane] != nullptr ? BiquadDesign::toStateVariable(*lanes[lane]) : StateVariableCoefficients();
+            a1[lane] = (SampleType) sv.a1;
+            a2[lane] = (SampleType) sv.a2;
+            a3[lane] = (SampleType) sv.a3;
+            m0[lane] = (SampleType) sv.m0;
+            m1[lane] = (SampleType) sv.m1;
+            m2[lane] = (SampleType) sv.m2;
+        }
+
+        v.a1 = Vec::fromRawArray(a1);
+        v.a2 = Vec::fromRawArray(a2);
+        v.a3 = Vec::fromRawArray(a3);
+        v.m0 = Vec::fromRawArray(m0);
+        v.m1 = Vec::fromRawArray(m1);
+        v.m2 = Vec::fromRawArray(m2);
+    }
+
+    static void reset(State& s) noexcept { s.ic1 = s.ic2 = Vec::expand((SampleType) 0); }
+    static void resetLane(State& s, size_t lane) noexcept { clearLane(s.ic1, lane); clearLane(s.ic2, lane); }
+
+    forcedinline static Vec process(const Coefficients& c, State& s, Vec x) noexcept
+    {
+        const auto v3 = x - s.ic2;
+        const auto v1 = c.a1 * s.ic1 + c.a2 * v3;
+        const auto v2 = s.ic2 + c.a2 * s.ic1 + c.a3 * v3;
+        s.ic1 = v1 + v1 - s.ic1;
+        s.ic2 = v2 + v2 - s.ic2;
+        return c.m0 * x + c.m1 * v1 + c.m2 * v2;
+    }
+};
+
+//Same LowCut -> Peak -> Bands -> HighCut cascade as MonoChain for any number of channels.
+//Channels are packed Vec::SIMDNumElements at a time into the lanes of a SIMD register
+//("groups"). There is one coefficient set shared by every group, and the
+//filter state of all groups sits in one contiguous array sized by prepare(), so cost
+//grows linearly with the channel count.
+//Samples are interleaved into a small aligned scratch buffer, the whole cascade runs per
+//sample with its state in registers, and the result is written back, so the output
+//matches MonoChain up to rounding (exactly, for TransposedDirectForm).
+//The loop is compiled once per combination of low cut stages, peak on/off and high cut
+//stages; setCoefficients picks the matching instantiation, so only the active sections
+//run, unrolled, without a per-stage branch. Neutral stages (no cut stages, 0 dB peak) are
+//left out, and with nothing left (flat) process() returns straight away.
+//Every parametric band has a slot of its own after those of the cuts and the peak, and the
+//band loop runs over the list of bands in use only.
+//A stage or band switching on or off is crossfaded against its own input over the fade
+//length, lane by lane, and one on its way out keeps its last coefficients until silent;
+//only while a fade runs does the generic loop with per-lane gains take over.
+//The first channel may be given its own coefficients (left/right or mid/side processing):
+//each stage then runs if any lane needs it, a lane without it passing straight through,
+//so both sides still share one pass, and a stage that switches in one lane fades in that
+//lane only. In mid/side mode the first two channels are matrixed to mid and side on the way
+//into the lanes and back on the way out.
+template<typename Vec, template<typename> class Topology = TransposedDirectForm>
+class VectorChain
+{
+public:
+    using SampleType = typename Vec::ElementType;
+    static constexpr int numLanes = (int) Vec::SIMDNumElements;
+
+    //not real-time safe, sizes the state array
+    void prepare(int numChannels)
+    {
+        numPreparedChannels = numChannels;
+        groups.resize((size_t) ((numChannels + numLanes - 1) / numLanes));
+        reset();
+    }
+
+    int getNumChannels() const noexcept { return numPreparedChannels; }
+
+    //samples a stage takes to fade in or out, at the rate the chain runs at
+    void setFadeLength(int numSamples) noexcept { fadeLength = juce::jmax(1, numSamples); }
+
+    //clears the state; the next setCoefficients takes effect without fades
+    void reset() noexcept
+    {
+        for(int slot = 0; slot < numAllSlots; slot++) {
+            resetSlot(slot);
+            stageGains[(size_t) slot].fill(0);
+            gainSteps[(size_t) slot].fill(0);
+            laneWanted[(size_t) slot].fill(false);
+        }
+
+        fading = false;
+        justReset = true;
+        processGroup = getGroupProcessor(0, false, 0);
+    }
+
+    //every channel the same
+    void setCoefficients(const ChainCoefficients& newCoefficients) noexcept
+    {
+        LaneCoefficients lanes;
+        lanes.fill(&newCoefficients);
+        setLaneCoefficients(lanes);
+    }
+
+    //the first channel (left or mid) takes `first`, every other one `second`
+    void setCoefficients(const ChainCoefficients& first, const ChainCoefficients& second) noexcept
+    {
+        LaneCoefficients lanes;
+        lanes.fill(&second);
+        lanes[0] = &first;
+        setLaneCoefficients(lanes);
+    }
+
+    //the first two channels run as mid and side; stereo only
+    void setMidSide(bool shouldUseMidSide) noexcept { midSide = shouldUseMidSide; }
+
+    const ChainCoefficients& getCoefficients() const noexcept { return coefficients; }
+
+    //every stage neutral and no fade running: process() does nothing
+    bool isFlat() const noexcept { return !fading && activeLowCut == 0 && !peakActive && activeHighCut == 0 && numBands == 0; }
+
+    //numChannels <= getNumChannels(), a partly filled last group is fed silence
+    void process(SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+    {
+        for(int group = 0; group < getNumGroups(numChannels); group++)
+            processChannelGroup(group, channels, numChannels, startSample, numSamples);
+
+        finishBlock(numSamples);
+    }
+
+    static int getNumGroups(int numChannels) noexcept { return (numChannels + numLanes - 1) / numLanes; }
+
+    //process() split up: the groups share nothing but the coefficients, so they may run in any order
+    //and on different threads at once; finishBlock follows once every group has run the block
+    void processChannelGroup(int group, SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+    {
+        jassert(numChannels <= numPreparedChannels && group < getNumGroups(numChannels));
+
+        const auto first = group * numLanes;
+        (this->*processGroup)(groups[(size_t) group], channels + first, juce::jmin(numLanes, numChannels - first), startSample, numSamples);
+    }
+
+    void finishBlock(int numSamples) noexcept
+    {
+        if(fading)
+            advanceFades(numSamples);
+    }
+
+private:
+    using Section = Topology<Vec>;
+    using VectorCoefficients = typename Section::Coefficients;
+    using VectorState = typename Section::State;
+    using LaneCoefficients = std::array<const ChainCoefficients*, (size_t) numLanes>;
+    using LaneStages = std::array<const BiquadCoefficients*, (size_t) numLanes>;
+
+    //fixed slot per stage so a slope change never hands one stage another's state,
+    //then one per band
+    enum { lowCutSlot = 0, peakSlot = maxCutStages, highCutSlot = maxCutStages + 1, numSlots = maxCutStages * 2 + 1,
+           bandSlot = numSlots, numAllSlots = numSlots + maxBands };
+    static constexpr int chunkSize = 64;
+
+    using GroupState = std::array<VectorState, numAllSlots>;
+    using GroupProcessor = void (VectorChain::*)(GroupState&, SampleType* const*, int, int, int) noexcept;
+    //one value per lane, exactly one register wide, so a row loads with fromRawArray
+    using LaneValues = std::array<SampleType, (size_t) numLanes>;
+
+    //0..maxCutStages stages per cut
+    static constexpr int numCutVariants = maxCutStages + 1;
+
+    void setLaneCoefficients(const LaneCoefficients& lanes) noexcept
+    {
+        const auto linked = std::all_of(lanes.begin() + 1, lanes.end(), [&](const ChainCoefficients* lane) { return lane == lanes[0]; });
+
+        for(auto& wanted : laneWanted)
+            wanted.fill(false);
+
+        //the sections a lane wants; one it no longer wants keeps the last, to fade out with
+        for(size_t lane = 0; lane < (linked ? 1 : lanes.size()); lane++) {
+            const auto& c = *lanes[lane];
+
+            auto want = [&](int slot, const BiquadCoefficients& section) {
+                laneWanted[(size_t) slot][lane] = true;
+                laneSections[(size_t) slot][lane] = section;
+            };
+
+            for(int i = 0; i < c.lowCut.numStages; i++)
+                want(lowCutSlot + i, c.lowCut.stages[(size_t) i]);
+
+            if(!c.peak.isNeutral())
+                want(peakSlot, c.peak);
+
+            for(int k = 0; k < c.bands.numBands; k++)
+                want(bandSlot + c.bands.bandIndices[(size_t) k], c.bands.stages[(size_t) k]);
+
+            for(int i = 0; i < c.highCut.numStages; i++)
+                want(highCutSlot + i, c.highCut.stages[(size_t) i]);
+        }
+
+        activeLowCut = activeHighCut = numBands = 0;
+        peakActive = false;
+        fading = false;
+
+        for(int slot = 0; slot < numAllSlots; slot++) {
+            auto& wanted = laneWanted[(size_t) slot];
+
+            if(linked && wanted[0]) {
+                wanted.fill(true);
+                laneSections[(size_t) slot].fill(laneSections[(size_t) slot][0]);
+            }
+
+            if(std::find(wanted.begin(), wanted.end(), true) != wanted.end()) {
+                if(slot < peakSlot)
+                    activeLowCut = slot - lowCutSlot + 1;
+                else if(slot == peakSlot)
+                    peakActive = true;
+                else if(slot < bandSlot)
+                    activeHighCut = slot - highCutSlot + 1;
+                else
+                    bandList[(size_t) numBands++] = slot - bandSlot;
+            }
+
+            for(size_t lane = 0; lane < (size_t) numLanes; lane++) {
+                const auto target = wanted[lane] ? (SampleType) 1 : (SampleType) 0;
+                auto& gain = stageGains[(size_t) slot][lane];
+                auto& step = gainSteps[(size_t) slot][lane];
+
+                if(justReset)
+                    gain = target;
+
+                step = target == gain ? (SampleType) 0
+                     : (target > gain ? (SampleType) 1 : (SampleType) -1) / (SampleType) fadeLength;
+                fading = fading || step != 0;
+            }
+
+            loadSlot(slot, linked);
+        }
+
+        justReset = false;
+        processGroup = fading ? &VectorChain::processFading : getGroupProcessor(activeLowCut, peakActive, activeHighCut);
+
+        coefficients = *lanes[0];
+    }
+
+    //a lane runs its section while it wants it or fades it out and passes through otherwise;
+    //a slot no lane runs is left alone
+    void loadSlot(int slot, bool linked) noexcept
+    {
+        const auto& wanted = laneWanted[(size_t) slot];
+        const auto& gains = stageGains[(size_t) slot];
+        auto& v = getSlotCoefficients(slot);
+
+        if(linked && wanted[0]) {
+            Section::setCoefficients(v, laneSections[(size_t) slot][0]);
+            return;
+        }
+
+        LaneStages stages;
+        bool anyRunning = false;
+
+        for(size_t lane = 0; lane < (size_t) numLanes; lane++) {
+            const auto runs = wanted[lane] || gains[lane] > 0;
+            stages[lane] = runs ? &laneSections[(size_t) slot][lane] : nullptr;
+            anyRunning = anyRunning || runs;
+        }
+
+        if(anyRunning)
+            Section::setCoefficients(v, stages.data());
+    }
+
+    VectorCoefficients& getSlotCoefficients(int slot) noexcept
+    {
+        return slot < numSlots ? vectorCoefficients[(size_t) slot] : bandCoefficients[(size_t) (slot - bandSlot)];
+    }
+
+    bool isRunning(int slot) const noexcept
+    {
+        for(size_t lane = 0; lane < (size_t) numLanes; lane++)
+            if(stageGains[(size_t) slot][lane] > 0 || gainSteps[(size_t) slot][lane] > 0)
+                return true;
+
+        return false;
+    }
+
+    //interleaves up to numLanes channels into scratch, runs processSample(x, sampleIndex) on every
+    //sample and writes the result back
+    template<typename ProcessSample>
+    void processInterleaved(SampleType* const* channels, int numChannels, int startSample, int numSamples, ProcessSample&& processSample) noexcept
+    {
+        //the matrix is applied while interleaving, so mid and side never need a buffer of their own
+        const auto matrixed = midSide && numChannels == 2;
+        const auto half = (SampleType) 0.5;
+
+        //on the stack, so groups can run on several threads
+        alignas(64) SampleType scratch[chunkSize * numLanes];
+
+        for(int start = 0; start < numSamples; start += chunkSize) {
+            const auto length = juce::jmin(chunkSize, numSamples - start);
+
+            if(matrixed) {
+                const auto* left = channels[0] + startSample + start;
+                const auto* right = channels[1] + startSample + start;
+
+                for(int i = 0; i < length; i++) {
+                    scratch[i * numLanes] = (left[i] + right[i]) * half;
+                    scratch[i * numLanes + 1] = (left[i] - right[i]) * half;
+                }
+            }
+            else {
+                for(int ch = 0; ch < numChannels; ch++) {
+                    const auto* input = channels[ch] + startSample + start;
+
+                    for(int i = 0; i < length; i++)
+                        scratch[i * numLanes + ch] = input[i];
+                }
+            }
+
+            for(int ch = numChannels; ch < numLanes; ch++)
+                for(int i = 0; i < length; i++)
+                    scratch[i * numLanes + ch] = 0;
+
+            for(int i = 0; i < length; i++) {
+                const auto x = processSample(Vec::fromRawArray(scratch + i * numLanes), start + i);
+                x.copyToRawArray(scratch + i * numLanes);
+            }
+
+            if(matrixed) {
+                auto* left = channels[0] + startSample + start;
+                auto* right = channels[1] + startSample + start;
+
+                for(int i = 0; i < length; i++) {
+                    const auto mid = scratch[i * numLanes], side = scratch[i * numLanes + 1];
+                    left[i] = mid + side;
+                    right[i] = mid - side;
+                }
+            }
+            else {
+                for(int ch = 0; ch < numChannels; ch++) {
+                    auto* output = channels[ch] + startSample + start;
+
+                    for(int i = 0; i < length; i++)
+                        output[i] = scratch[i * numLanes + ch];
+                }
+            }
+        }
+    }
+
+    forcedinline Vec processBands(const VectorCoefficients* c, VectorState* s, Vec x) const noexcept
+    {
+        for(int k = 0; k < numBands; k++) {
+            const auto band = bandList[(size_t) k];
+            x = Section::process(c[band], s[bandSlot + band], x);
+        }
+
+        return x;
+    }
+
+    template<int firstSlot, int... stage>
+    forcedinline static Vec processStages(std::integer_sequence<int, stage...>, const VectorCoefficients* c, VectorState* s, Vec x) noexcept
+    {
+        juce::ignoreUnused(c, s);
+        ((x = Section::process(c[firstSlot + stage], s[firstSlot + stage], x)), ...);
+        return x;
+    }
+
+    template<int numLowCut, bool hasPeak, int numHighCut>
+    void processStaged(GroupState& groupState, SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+    {
+        if constexpr(numLowCut == 0 && !hasPeak && numHighCut == 0) {
+            if(numBands == 0)
+                return;
+        }
+
+        //local copies, so the compiler can keep the whole cascade in registers
+        const auto c = vectorCoefficients;
+        auto state = groupState;
+
+        processInterleaved(channels, numChannels, startSample, numSamples, [&](Vec x, int) {
+            x = processStages<lowCutSlot>(std::make_integer_sequence<int, numLowCut>(), c.data(), state.data(), x);
+
+            if constexpr(hasPeak)
+                x = Section::process(c[peakSlot], state[peakSlot], x);
+
+            x = processBands(bandCoefficients.data(), state.data(), x);
+
+            return processStages<highCutSlot>(std::make_integer_sequence<int, numHighCut>(), c.data(), state.data(), x);
+        });
+
+        groupState = state;
+    }
+
+    //every stage and band that is on or fading, in chain order; where a lane fades, the stage's
+    //output is mixed with its input by the lane's gain
+    void processFading(GroupState& groupState, SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+    {
+        std::array<int, numAllSlots> running;
+        int numRunning = 0;
+
+        auto addIfRunning = [&](int slot) {
+            if(isRunning(slot))
+                running[(size_t) numRunning++] = slot;
+        };
+
+        for(int slot = lowCutSlot; slot <= peakSlot; slot++)
+            addIfRunning(slot);
+
+        for(int band = 0; band < maxBands; band++)
+            addIfRunning(bandSlot + band);
+
+        for(int slot = highCutSlot; slot < highCutSlot + maxCutStages; slot++)
+            addIfRunning(slot);
+
+        std::array<const VectorCoefficients*, numAllSlots> runningCoefficients;
+        std::array<Vec, numAllSlots> startGains, steps;
+        std::array<bool, numAllSlots> ramping;
+
+        for(int k = 0; k < numRunning; k++) {
+            const auto slot = running[(size_t) k];
+            runningCoefficients[(size_t) k] = &getSlotCoefficients(slot);
+            startGains[(size_t) k] = Vec::fromRawArray(stageGains[(size_t) slot].data());
+            steps[(size_t) k] = Vec::fromRawArray(gainSteps[(size_t) slot].data());
+
+            const auto& laneSteps = gainSteps[(size_t) slot];
+            ramping[(size_t) k] = std::any_of(laneSteps.begin(), laneSteps.end(), [](SampleType step) { return step != 0; });
+        }
+
+        const auto zero = Vec::expand((SampleType) 0), one = Vec::expand((SampleType) 1);
+        auto state = groupState;
+
+        processInterleaved(channels, numChannels, startSample, numSamples, [&](Vec x, int sampleIndex) {
+            for(int k = 0; k < numRunning; k++) {
+                const auto y = Section::process(*runningCoefficients[(size_t) k], state[(size_t) running[(size_t) k]], x);
+
+                if(!ramping[(size_t) k]) {
+                    x = y;
+                }
+                else {
+                    const auto gain = Vec::min(one, Vec::max(zero, startGains[(size_t) k] + steps[(size_t) k] * (SampleType) (sampleIndex + 1)));
+                    x = x + (y - x) * gain;
+                }
+            }
+
+            return x;
+        });
+
+        groupState = state;
+    }
+
+    //after every group has run numSamples of the fade; a lane that reached silence is cleared
+    //and passes through from then on
+    void advanceFades(int numSamples) noexcept
+    {
+        fading = false;
+
+        for(int slot = 0; slot < numAllSlots; slot++) {
+            bool laneStopped = false;
+
+            for(size_t lane = 0; lane < (size_t) numLanes; lane++) {
+                auto& step = gainSteps[(size_t) slot][lane];
+
+                if(step == 0)
+                    continue;
+
+                auto& gain = stageGains[(size_t) slot][lane];
+                gain = juce::jlimit((SampleType) 0, (SampleType) 1, gain + step * (SampleType) numSamples);
+
+                if(gain == (step > 0 ? (SampleType) 1 : (SampleType) 0)) {
+                    if(gain == 0) {
+                        resetLane(slot, lane);
+                        laneStopped = true;
+                    }
+
+                    step = 0;
+                }
+                else {
+                    fading = true;
+                }
+            }
+
+            if(laneStopped)
+                loadSlot(slot, false);
+        }
+
+        if(!fading)
+            processGroup = getGroupProcessor(activeLowCut, peakActive, activeHighCut);
+    }
+
+    template<std::size_t... index>
+    static constexpr std::array<GroupProcessor, sizeof...(index)> makeGroupProcessors(std::index_sequence<index...>) noexcept
+    {
+        return { { &VectorChain::processStaged<(int) (index / (2 * numCutVariants)),
+                                               (index / numCutVariants) % 2 == 1,
+                                               (int) (index % numCutVariants)>... } };
+    }
+
+    static GroupProcessor getGroupProcessor(int numLowCut, bool hasPeak, int numHighCut) noexcept
+    {
+        static constexpr auto processors = makeGroupProcessors(std::make_index_sequence<numCutVariants * 2 * numCutVariants>());
+
+        jassert(numLowCut >= 0 && numLowCut <= maxCutStages && numHighCut >= 0 && numHighCut <= maxCutStages);
+        return processors[(size_t) ((numLowCut * 2 + (hasPeak ? 1 : 0)) * numCutVariants + numHighCut)];
+    }
+
+    void resetSlot(int slot) noexcept
+    {
+        for(auto& group : groups)
+            Section::reset(group[(size_t) slot]);
+    }
+
+    void resetLane(int slot, size_t lane) noexcept
+    {
+        for(auto& group : groups)
+            Section::resetLane(group[(size_t) slot], lane);
+    }
+
+    ChainCoefficients coefficients;
+
+    std::array<VectorCoefficients, numSlots> vectorCoefficients;
+    std::array<VectorCoefficients, maxBands> bandCoefficients;
+    //bands any lane wants, in band order
+    std::array<int, maxBands> bandList {};
+    int numBands = 0;
+    int activeLowCut = 0, activeHighCut = 0;
+    bool peakActive = false;
+    GroupProcessor processGroup = getGroupProcessor(0, false, 0);
+
+    //per slot and lane: whether the lane wants the stage, the section it last had, the mix of the
+    //stage output against its input (0 = off) and its change per sample
+    std::array<std::array<bool, (size_t) numLanes>, numAllSlots> laneWanted {};
+    std::array<std::array<BiquadCoefficients, (size_t) numLanes>, numAllSlots> laneSections;
+    alignas(64) std::array<LaneValues, numAllSlots> stageGains {};
+    alignas(64) std::array<LaneValues, numAllSlots> gainSteps {};
+    int fadeLength = 256;
+    bool fading = false, justReset = true;
+    bool midSide = false;
+
+    std::vector<GroupState> groups;
+    int numPreparedChannels = 0;
+};
+
+using SIMDChain = VectorChain<juce::dsp::SIMDRegister<float>>;
+using SIMDStateVariableChain = VectorChain<juce::dsp::SIMDRegister<float>, StateVariable>;
+using SIMDChainDouble = VectorChain<juce::dsp::SIMDRegister<double>>;
@@ -0,0 +1,193 @@
+#include "SpectrumAnalyser.h"
+
+SpectrumAnalyser::SpectrumAnalyser() : juce::Thread("Spectrum Analyser")
+{
+    allocate();
+}
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+    stopThread(1000);
+}
+
+void SpectrumAnalyser::prepare(double newSampleRate) {
+
+    stopThread(1000);
+    sampleRate = newSampleRate;
+    restart();
+}
+
+void SpectrumAnalyser::setEnabled(bool shouldBeEnabled) {
+
+    enabled.store(shouldBeEnabled);
+
+    if(shouldBeEnabled)
+        restart();
+    else
+        stopThread(1000);
+}
+
+void SpectrumAnalyser::configure(int newFFTOrder, int newOverlap) {
+
+    stopThread(1000);
+
+    fftOrder = juce::jlimit(9, 14, newFFTOrder);
+    overlap = juce::jlimit(1, 8, juce::nextPowerOfTwo(newOverlap));
+    allocate();
+
+    restart();
+}
+
+void SpectrumAnalyser::restart() {
+
+    if(enabled.load() && !isThreadRunning())
+        startThread();
+}
+
+void SpectrumAnalyser::allocate() {
+
+    const auto fftSize = 1 << fftOrder;
+
+    fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+    window = std::make_unique<juce::dsp::WindowingFunction<float>>((size_t) fftSize,
+                                                                   juce::dsp::WindowingFunction<float>::hann,
+                                                                   false);
+
+    for(auto& tap : taps) {
+        tap.history.assign((size_t) fftSize, 0.0f);
+        tap.frame.assign((size_t) fftSize * 2, 0.0f);
+        tap.averagedPower.assign((size_t) fftSize / 2 + 1, 0.0f);
+    }
+}
+
+template<typename SampleType>
+void SpectrumAnalyser::push(Tap tap, const SampleType* const* channels, int numChannels, int numSamples) noexcept {
+
+    if(!enabled.load(std::memory_order_relaxed) || numChannels <= 0)
+        return;
+
+    auto& state = taps[(size_t) tap];
+
+    //a full FIFO means the analyser is behind, the newest samples are dropped
+    numSamples = juce::jmin(numSamples, state.fifo.getFreeSpace());
+
+    int start1, size1, start2, size2;
+    state.fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    const auto gain = 1.0f / (float) numChannels;
+
+    auto mixdown = [&](float* destination, int sourceOffset, int size) {
+        if constexpr (std::is_same<SampleType, float>::value) {
+            juce::FloatVectorOperations::copyWithMultiply(destination, channels[0] + sourceOffset, gain, size);
+
+            for(int ch = 1; ch < numChannels; ch++)
+                juce::FloatVectorOperations::addWithMultiply(destination, channels[ch] + sourceOffset, gain, size);
+        }
+        else {
+            for(int i = 0; i < size; i++) {
+                SampleType sum = 0;
+
+                for(int ch = 0; ch < numChannels; ch++)
+                    sum += channels[ch][sourceOffset + i];
+
+                destination[i] = (float) sum * gain;
+            }
+        }
+    };
+
+    if(size1 > 0)
+        mixdown(state.fifoBuffer.data() + start1, 0, size1);
+
+    if(size2 > 0)
+        mixdown(state.fifoBuffer.data() + start2, size1, size2);
+
+    state.fifo.finishedWrite(size1 + size2);
+}
+
+template void SpectrumAnalyser::push<float>(Tap, const float* const*, int, int) noexcept;
+template void SpectrumAnalyser::push<double>(Tap, const double* const*, int, int) noexcept;
+
+const SpectrumAnalyser::Spectrum* SpectrumAnalyser::pullSpectrum() noexcept {
+    return spectra.pull() ? &spectra.getReadBuffer() : nullptr;
+}
+
+void SpectrumAnalyser::run() {
+
+    while(!threadShouldExit()) {
+        bool produced = false;
+
+        for(auto& tap : taps)
+            while(analyse(tap))
+                produced = true;
+
+        if(produced)
+            publish();
+
+        //the audio thread never signals, so the FIFOs are polled
+        wait(10);
+    }
+}
+
+bool SpectrumAnalyser::analyse(TapState& tap) {
+
+    const auto fftSize = 1 << fftOrder;
+    const auto hopSize = fftSize / overlap;
+
+    if(tap.fifo.getNumReady() < hopSize)
+        return false;
+
+    //slide the history by one hop and append the new samples
+    std::copy(tap.history.begin() + hopSize, tap.history.end(), tap.history.begin());
+
+    int start1, size1, start2, size2;
+    tap.fifo.prepareToRead(hopSize, start1, size1, start2, size2);
+
+    auto* destination = tap.history.data() + fftSize - hopSize;
+    std::copy_n(tap.fifoBuffer.data() + start1, size1, destination);
+    std::copy_n(tap.fifoBuffer.data() + start2, size2, destination + size1);
+
+    tap.fifo.finishedRead(size1 + size2);
+
+    std::copy(tap.history.begin(), tap.history.end(), tap.frame.begin());
+    window->multiplyWithWindowingTable(tap.frame.data(), (size_t) fftSize);
+    fft->performFrequencyOnlyForwardTransform(tap.frame.data());
+
+    //exponential average of the power, roughly 100 ms at the default settings
+    constexpr float smoothing = 0.8f;
+
+    //Hann window has a coherent gain of 0.5, so a full-scale sine reads 0 dB
+    const auto scale = 2.0f / (fftSize * 0.5f);
+
+    for(size_t bin = 0; bin < tap.averagedPower.size(); bin++) {
+        const auto magnitude = tap.frame[bin] * scale;
+        tap.averagedPower[bin] = smoothing * tap.averagedPower[bin] + (1.0f - smoothing) * magnitude * magnitude;
+    }
+
+    return true;
+}
+
+void SpectrumAnalyser::publish() {
+
+    auto& spectrum = spectra.getWriteBuffer();
+    const auto fftSize = 1 << fftOrder;
+    const auto binsPerHz = fftSize / sampleRate;
+
+    for(size_t t = 0; t < taps.size(); t++) {
+        const auto& power = taps[t].averagedPower;
+        const auto lastBin = (float) (power.size() - 1);
+
+        for(int i = 0; i < numPoints; i++) {
+            const auto frequency = juce::mapToLog10((float) i / (float) numPoints, minFrequency, maxFrequency);
+            const auto bin = juce::jlimit(0.0f, lastBin, (float) (frequency * binsPerHz));
+
+            //linear interpolation between the two neighbouring bins
+            const auto index = juce::jmin((size_t) bin, power.size() - 2);
+            const auto fraction = bin - (float) index;
+            const auto value = power[index] + fraction * (power[index + 1] - power[index]);
+
+            spectrum.decibels[t][(size_t) i] = juce::Decibels::gainToDecibels(std::sqrt(value), -120.0f);
+        }
+    }
+
+    spectra.publish();
+}
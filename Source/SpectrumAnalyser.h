@@ -0,0 +1,63 @@
+#pragma once
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+//Input/output spectrum for the editor, computed on a background thread from lock-free FIFOs.
+class SpectrumAnalyser : private juce::Thread
+{
+public:
+    enum Tap { PreFilter, PostFilter, numTaps };
+
+    static constexpr int numPoints = 256;
+    static constexpr float minFrequency = 20.0f, maxFrequency = 20000.0f;
+
+    struct Spectrum {
+        //dB per log-spaced point from minFrequency to maxFrequency, one row per tap
+        std::array<std::array<float, numPoints>, numTaps> decibels;
+    };
+
+    SpectrumAnalyser();
+    ~SpectrumAnalyser() override;
+
+    //message thread
+    void prepare(double sampleRate);
+    void setEnabled(bool shouldBeEnabled);
+    //fftOrder 9..14 (512..16384 points), overlap = frames per FFT length (1, 2, 4 or 8)
+    void configure(int fftOrder, int overlap);
+
+    //audio thread, does nothing while disabled; float and double
+    template<typename SampleType>
+    void push(Tap tap, const SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    //message thread: newest spectrum, or nullptr when nothing new has been computed
+    const Spectrum* pullSpectrum() noexcept;
+
+private:
+    static constexpr int fifoSize = 1 << 16;
+
+    struct TapState {
+        juce::AbstractFifo fifo { fifoSize };
+        std::vector<float> fifoBuffer = std::vector<float>(fifoSize);
+
+        //analyser thread only
+        std::vector<float> history, frame, averagedPower;
+    };
+
+    void run() override;
+    void allocate();
+    void restart();
+    bool analyse(TapState& tapState);
+    void publish();
+
+    std::array<TapState, numTaps> taps;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    int fftOrder { 11 }, overlap { 4 };
+    double sampleRate { 44100.0 };
+
+    std::atomic<bool> enabled { false };
+    TripleBuffer<Spectrum> spectra;
+
+    JUCE_DECLARE_NON_COPYABLE(SpectrumAnalyser)
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <atomic>
+
+//Lock-free single-writer / single-reader handoff of a value.
+//The writer fills getWriteBuffer() and calls publish(); the reader calls pull()
+//and, if it returns true, reads the newest value from getReadBuffer().
+//Neither side ever blocks or allocates, and each side owns its slot exclusively.
+template<typename T>
+class TripleBuffer
+{
+public:
+    T& getWriteBuffer() noexcept { return slots[writeIndex]; }
+
+    void publish() noexcept
+    {
+        writeIndex = shared.exchange(writeIndex | dirtyBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    bool pull() noexcept
+    {
+        if((shared.load(std::memory_order_acquire) & dirtyBit) == 0)
+            return false;
+
+        readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const T& getReadBuffer() const noexcept { return slots[readIndex]; }
+    //the reader owns its slot until the next pull, so it may also swap contents out of it
+    T& getReadBuffer() noexcept { return slots[readIndex]; }
+
+private:
+    static constexpr int dirtyBit = 4;
+    static constexpr int indexMask = 3;
+
+    std::array<T, 3> slots;
+    std::atomic<int> shared { 1 };
+    int writeIndex = 0, readIndex = 2;
+};